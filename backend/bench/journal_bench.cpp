@@ -0,0 +1,180 @@
+// Measures the write-ahead journal: append throughput under each sync
+// policy, committing once per simulated shard pass, the time to replay the
+// journal into a fresh OrderBook, and the time to restore a book of resting
+// orders from a snapshot instead.
+//
+// Output is one line per run: policy, records, pass size, appends per
+// second and nanoseconds per record; then one replay line with records,
+// milliseconds, records per second and the levels left resting; then one
+// restore line with orders, snapshot bytes, write and restore
+// milliseconds. Files are written under the directory given as the first
+// argument (default: the system temp dir).
+
+#include "journal.hpp"
+#include "order_book.hpp"
+#include "snapshot.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Adds around 100, some crossing, and cancels of random earlier ids. As
+    // in a shard, only commands the book accepts are kept for the journal.
+    std::vector<JournalEntry> make_commands(std::size_t count)
+    {
+        NullLogger logger;
+        OrderBook book(&logger);
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<int> price_dist(90, 110);
+        std::uniform_int_distribution<int> quantity_dist(1, 10);
+        std::uniform_int_distribution<int> action_dist(0, 2);
+
+        std::vector<JournalEntry> commands;
+        commands.reserve(count);
+        OrderID next_id = 1;
+        while (commands.size() < count)
+        {
+            JournalEntry entry;
+            entry.symbol = default_symbol;
+            if (action_dist(gen) == 0 && next_id > 1)
+            {
+                entry.command = JournalCommand::cancel;
+                entry.id = std::uniform_int_distribution<OrderID>(1, next_id - 1)(gen);
+            }
+            else
+            {
+                entry.command = JournalCommand::add;
+                entry.id = next_id++;
+                entry.side = gen() % 2 ? OrderSide::buy : OrderSide::sell;
+                entry.price = price_dist(gen);
+                entry.quantity = static_cast<Quantity>(quantity_dist(gen));
+            }
+            try
+            {
+                if (entry.command == JournalCommand::add)
+                    book.add_order(entry.id, entry.type, entry.side, entry.price, entry.quantity);
+                else
+                    book.cancel_order(entry.id);
+            }
+            catch (const std::exception &)
+            {
+                continue;
+            }
+            commands.push_back(entry);
+        }
+        return commands;
+    }
+
+    void bench_append(const std::string &directory, const char *name, JournalSync sync,
+                      const std::vector<JournalEntry> &commands, std::size_t pass_size)
+    {
+        std::filesystem::remove_all(directory);
+        JournalConfig config;
+        config.directory = directory;
+        config.sync = sync;
+        Journal journal(config);
+
+        auto start = std::chrono::steady_clock::now();
+        std::size_t in_pass = 0;
+        for (const JournalEntry &entry : commands)
+        {
+            journal.append(entry);
+            if (++in_pass == pass_size)
+            {
+                journal.commit();
+                in_pass = 0;
+            }
+        }
+        journal.commit();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "policy=" << name
+                  << " records=" << commands.size()
+                  << " pass_size=" << pass_size
+                  << " appends_per_sec=" << static_cast<std::uint64_t>(commands.size() / seconds)
+                  << " ns_per_record=" << seconds * 1e9 / commands.size() << "\n";
+    }
+
+    void bench_replay(const std::string &directory)
+    {
+        NullLogger logger;
+        OrderBook book(&logger);
+        std::uint64_t records = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        Journal::replay(directory, [&](const JournalEntry &entry) {
+            ++records;
+            if (entry.command == JournalCommand::add)
+                book.add_order(entry.id, entry.type, entry.side, entry.price, entry.quantity);
+            else if (entry.command == JournalCommand::cancel)
+                book.cancel_order(entry.id);
+            else
+                book.modify_order(entry.id, entry.price, entry.quantity);
+        });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "replay records=" << records
+                  << " ms=" << seconds * 1e3
+                  << " records_per_sec=" << static_cast<std::uint64_t>(records / seconds)
+                  << " resting_bids=" << book.get_bids().size()
+                  << " resting_asks=" << book.get_asks().size() << "\n";
+    }
+
+    // A deep, uncrossed book: the case where replaying history would cost the most.
+    void bench_restore(const std::string &directory, std::size_t order_count)
+    {
+        NullLogger logger;
+        OrderBook book(&logger);
+        for (std::size_t i = 0; i < order_count; ++i)
+        {
+            bool buy = i % 2 == 0;
+            Price price = buy ? 90 + static_cast<Price>(i % 10) : 101 + static_cast<Price>(i % 10);
+            book.add_order(i + 1, OrderType::good_till_cancel, buy ? OrderSide::buy : OrderSide::sell, price, 10);
+        }
+
+        std::filesystem::create_directories(directory);
+        std::string path = (std::filesystem::path(directory) / "snapshot.bin").string();
+        auto start = std::chrono::steady_clock::now();
+        write_snapshot(path, 1, {{default_symbol, book.get_resting_orders()}});
+        double write_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        OrderBook restored(&logger);
+        start = std::chrono::steady_clock::now();
+        std::uint64_t sequence = 0;
+        std::vector<BookSnapshot> books;
+        read_snapshot(path, sequence, books);
+        restored.restore_orders(books.front().orders);
+        double restore_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "restore orders=" << order_count
+                  << " bytes=" << std::filesystem::file_size(path)
+                  << " write_ms=" << write_seconds * 1e3
+                  << " restore_ms=" << restore_seconds * 1e3
+                  << " orders_per_sec=" << static_cast<std::uint64_t>(order_count / restore_seconds) << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::filesystem::path base = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path();
+    std::string directory = (base / "orderbook-journal-bench").string();
+
+    const std::vector<JournalEntry> commands = make_commands(1000000);
+    bench_append(directory, "none", JournalSync::none, commands, 256);
+    // Syncing every record is orders of magnitude slower; a sample is enough.
+    bench_append(directory, "every", JournalSync::every,
+                 std::vector<JournalEntry>(commands.begin(), commands.begin() + 2000), 256);
+    for (std::size_t pass_size : {16, 256})
+        bench_append(directory, "group", JournalSync::group, commands, pass_size);
+
+    // The last run left every command in the journal.
+    bench_replay(directory);
+    bench_restore(directory, 1000000);
+
+    std::filesystem::remove_all(directory);
+}
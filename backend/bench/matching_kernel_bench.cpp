@@ -0,0 +1,197 @@
+// Compares the compile-time specialized matching kernel in MatchingEngine
+// with the previous loop that branched on side and order type for every
+// level and fill. Both run on identical books built from the same pool.
+//
+// Each configuration is timed `samples` times, alternating the two kernels
+// so that frequency and cache drift hit both alike, and every sample sweeps
+// about 200k fills. Output is one line per kernel and configuration: levels,
+// orders per level, fills per sample, and the median and minimum nanoseconds
+// per fill over the samples.
+
+#include "matching_engine.hpp"
+#include "order_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace
+{
+    using AskLevels = std::map<Price, PriceLevel, std::less<Price>>;
+
+    struct BenchListener
+    {
+        OrderPool &pool;
+        std::uint64_t trades = 0;
+
+        void on_trade(const Trade &) { ++trades; }
+        void on_resting_filled(OrderPointer order) { pool.release(order); }
+        void on_order_killed(OrderPointer order) { order->cancel(); }
+        void on_level_changed(OrderSide, Price) {}
+    };
+
+    // The matching loop as it was before specialization, kept as a baseline.
+    class RuntimeDispatchEngine
+    {
+    public:
+        RuntimeDispatchEngine(BenchListener &listener, Logger &logger) : listener_(listener), logger_(logger) {}
+
+        template <typename OppositeMap>
+        void match_order(OrderPointer aggressive_order, OppositeMap &opposite_book)
+        {
+            if (aggressive_order->get_type() == OrderType::fill_or_kill &&
+                get_available_quantity(aggressive_order, opposite_book) < aggressive_order->get_remaining_quantity())
+            {
+                listener_.on_order_killed(aggressive_order);
+                return;
+            }
+
+            while (!opposite_book.empty() && aggressive_order->get_remaining_quantity() > 0)
+            {
+                auto best_it = opposite_book.begin();
+                if (!is_price_acceptable(aggressive_order, best_it->first))
+                    break;
+                auto &level = best_it->second;
+                process_price_level(aggressive_order, level);
+                if (level.empty())
+                    opposite_book.erase(best_it);
+            }
+
+            if (aggressive_order->get_type() != OrderType::good_till_cancel &&
+                aggressive_order->get_remaining_quantity() > 0)
+                listener_.on_order_killed(aggressive_order);
+        }
+
+    private:
+        bool is_price_acceptable(OrderPointer aggressive_order, Price best_price) const
+        {
+            return (aggressive_order->get_side() == OrderSide::buy)
+                       ? (aggressive_order->get_price() >= best_price)
+                       : (aggressive_order->get_price() <= best_price);
+        }
+
+        template <typename OppositeMap>
+        Quantity get_available_quantity(OrderPointer aggressive_order, const OppositeMap &opposite_book) const
+        {
+            Quantity total = 0;
+            for (auto it = opposite_book.begin(); it != opposite_book.end(); ++it)
+            {
+                if (!is_price_acceptable(aggressive_order, it->first))
+                    break;
+                total += it->second.total_quantity;
+                if (total >= aggressive_order->get_remaining_quantity())
+                    return total;
+            }
+            return total;
+        }
+
+        void process_price_level(OrderPointer aggressive_order, PriceLevel &level)
+        {
+            while (!level.empty() && aggressive_order->get_remaining_quantity() > 0)
+            {
+                OrderPointer resting_order = level.front();
+                level.reduce(execute_trade(aggressive_order, resting_order));
+                if (resting_order->get_remaining_quantity() == 0)
+                {
+                    level.pop_front();
+                    listener_.on_resting_filled(resting_order);
+                }
+            }
+        }
+
+        Quantity execute_trade(OrderPointer aggressive_order, OrderPointer resting_order)
+        {
+            Quantity trade_quantity = std::min(aggressive_order->get_remaining_quantity(),
+                                               resting_order->get_remaining_quantity());
+            aggressive_order->fill(trade_quantity);
+            resting_order->fill(trade_quantity);
+
+            Price execution_price = resting_order->get_price();
+            if (aggressive_order->get_side() == OrderSide::buy)
+                listener_.on_trade(Trade(aggressive_order->get_id(), resting_order->get_id(), execution_price, trade_quantity));
+            else
+                listener_.on_trade(Trade(resting_order->get_id(), aggressive_order->get_id(), execution_price, trade_quantity));
+            logger_.event<LogLevel::debug>(LogEvent::trade,
+                                           static_cast<std::int64_t>(aggressive_order->get_id()),
+                                           static_cast<std::int64_t>(resting_order->get_id()),
+                                           execution_price);
+            return trade_quantity;
+        }
+
+        BenchListener &listener_;
+        Logger &logger_;
+    };
+
+    void fill_asks(AskLevels &asks, OrderPool &pool, int levels, int orders_per_level, OrderID &next_id)
+    {
+        for (int level = 0; level < levels; ++level)
+        {
+            Price price = 100 + level;
+            for (int i = 0; i < orders_per_level; ++i)
+                asks[price].push_back(pool.acquire(next_id++, OrderType::good_till_cancel, OrderSide::sell, price, 1));
+        }
+    }
+
+    // Nanoseconds per fill over `rounds` sweeps of a fresh book.
+    template <typename Engine>
+    double run(int levels, int orders_per_level, int rounds)
+    {
+        OrderPool pool;
+        BenchListener listener{pool};
+        Engine engine(listener, get_default_logger());
+        AskLevels asks;
+        OrderID next_id = 1;
+        std::chrono::nanoseconds elapsed{0};
+
+        for (int round = 0; round < rounds; ++round)
+        {
+            fill_asks(asks, pool, levels, orders_per_level, next_id);
+            Quantity sweep = static_cast<Quantity>(levels * orders_per_level);
+            OrderPointer aggressive = pool.acquire(next_id++, OrderType::immediate_or_cancel, OrderSide::buy,
+                                                   100 + levels, sweep);
+
+            auto start = std::chrono::steady_clock::now();
+            engine.match_order(aggressive, asks);
+            elapsed += std::chrono::steady_clock::now() - start;
+
+            pool.release(aggressive);
+        }
+
+        return static_cast<double>(elapsed.count()) / static_cast<double>(listener.trades);
+    }
+
+    void report(const char *kernel, int levels, int orders_per_level, int fills, std::vector<double> &samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        std::cout << "kernel=" << kernel
+                  << " levels=" << levels
+                  << " orders_per_level=" << orders_per_level
+                  << " fills=" << fills
+                  << " median_ns_per_fill=" << samples[samples.size() / 2]
+                  << " min_ns_per_fill=" << samples.front() << "\n";
+    }
+}
+
+int main()
+{
+    const int samples = 9;
+    const int fills_per_sample = 200000;
+    for (int levels : {1, 10, 100})
+    {
+        for (int orders_per_level : {1, 10, 100})
+        {
+            int rounds = fills_per_sample / (levels * orders_per_level);
+            std::vector<double> runtime_dispatch;
+            std::vector<double> specialized;
+            for (int sample = 0; sample < samples; ++sample)
+            {
+                runtime_dispatch.push_back(run<RuntimeDispatchEngine>(levels, orders_per_level, rounds));
+                specialized.push_back(run<MatchingEngine<BenchListener>>(levels, orders_per_level, rounds));
+            }
+            report("runtime_dispatch", levels, orders_per_level, fills_per_sample, runtime_dispatch);
+            report("specialized", levels, orders_per_level, fills_per_sample, specialized);
+        }
+    }
+}
@@ -0,0 +1,577 @@
+// Microbenchmarks of OrderBook operations on books of a given shape.
+//
+// Each case builds a book with `depth` price levels per side around a mid of
+// 10000 and `orders_per_level` orders queued at every level, then times one
+// operation in batches, restoring the book's shape between batches outside
+// the timed region. New passive prices are drawn from a geometric
+// distribution away from the touch, so most activity lands near the top of
+// the book as it does in real flow.
+//
+// Cases:
+//   add_passive      GTC order that rests without trading
+//   sweep            IOC order that trades through every level of one side
+//   cancel_front     cancel of the first, middle or last order of a level
+//   cancel_middle
+//   cancel_back
+//   modify           price and quantity change of a resting order (re-queues it)
+//   modify_reduce    one-lot reduce at the same price (keeps the queue position)
+//   fok_kill         FOK larger than the whole opposite side, killed after the liquidity check
+//   trade            one-lot IOC that takes the front order of the opposite side
+//   trade_with_stops the same with depth x orders_per_level stops pending on each side,
+//                    none of which it triggers
+//   stop_trigger     per stop, a trade at the touch triggering 256 stop-limit orders that
+//                    then rest without trading
+//   iceberg_refill   one-lot IOC against a level of icebergs showing one lot each, so
+//                    every trade refills the front iceberg at the back of its level
+//   get_levels_all   get_bids + get_asks of the full book
+//   get_levels_top10 get_bids(10) + get_asks(10)
+//
+// Output is one line per case and shape, in key=value form so runs from two
+// commits can be compared line by line:
+//   bench=<case> layout=<tree|ladder> depth=<n> orders_per_level=<n> ops=<n> ns_per_op=<x>
+// where ops is the number of operations actually timed.
+//
+// Options: --layout tree|ladder|both, --depth a,b,..., --orders a,b,...,
+// --ops N (timed operations per case), --filter SUBSTRING.
+
+#include "order_book.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr Price mid_price = 10000;
+
+    struct Shape
+    {
+        BookLayout layout;
+        std::size_t depth;
+        std::size_t orders_per_level;
+    };
+
+    struct Options
+    {
+        std::vector<BookLayout> layouts{BookLayout::tree, BookLayout::ladder};
+        std::vector<std::size_t> depths{1, 10, 100, 1000};
+        std::vector<std::size_t> orders_per_level{1, 10, 100};
+        std::size_t ops = 200000;
+        std::string filter;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    // A book of the requested shape plus the queue order of every level, so
+    // cases can pick orders by position and put the shape back afterwards.
+    class Fixture
+    {
+    public:
+        explicit Fixture(const Shape &shape, Quantity resting_quantity = 1)
+            : shape_(shape), resting_quantity_(resting_quantity), book_(&logger_, config_for(shape)),
+              bid_queues_(shape.depth), ask_queues_(shape.depth)
+        {
+            for (std::size_t level = 0; level < shape.depth; ++level)
+            {
+                for (std::size_t i = 0; i < shape.orders_per_level; ++i)
+                {
+                    rest(OrderSide::buy, level);
+                    rest(OrderSide::sell, level);
+                }
+            }
+        }
+
+        OrderBook &book() { return book_; }
+        OrderID next_id() { return next_id_++; }
+
+        static Price price_of(OrderSide side, std::size_t level)
+        {
+            return side == OrderSide::buy ? mid_price - 1 - static_cast<Price>(level)
+                                          : mid_price + 1 + static_cast<Price>(level);
+        }
+
+        std::deque<OrderID> &queue(OrderSide side, std::size_t level)
+        {
+            return side == OrderSide::buy ? bid_queues_[level] : ask_queues_[level];
+        }
+
+        // Adds a resting order of the fixture's size (one lot by default) at the back of a level.
+        OrderID rest(OrderSide side, std::size_t level)
+        {
+            OrderID id = next_id();
+            book_.add_order(id, OrderType::good_till_cancel, side, price_of(side, level), resting_quantity_);
+            queue(side, level).push_back(id);
+            return id;
+        }
+
+        // Level index of a passive price: geometric away from the touch, within the book.
+        std::size_t passive_level(std::mt19937 &gen)
+        {
+            std::size_t level = static_cast<std::size_t>(touch_distance_(gen));
+            return std::min(level, shape_.depth - 1);
+        }
+
+    private:
+        static BookConfig config_for(const Shape &shape)
+        {
+            BookConfig config;
+            config.layout = shape.layout;
+            config.center_price = mid_price;
+            config.order_capacity = 2 * shape.depth * shape.orders_per_level + 4096;
+            return config;
+        }
+
+        Shape shape_;
+        Quantity resting_quantity_;
+        NullLogger logger_;
+        OrderBook book_;
+        std::vector<std::deque<OrderID>> bid_queues_;
+        std::vector<std::deque<OrderID>> ask_queues_;
+        OrderID next_id_ = 1;
+        std::geometric_distribution<int> touch_distance_{0.3};
+    };
+
+    struct Timing
+    {
+        std::size_t ops = 0;
+        double ns_per_op = 0;
+    };
+
+    // Runs `batch()`, which returns how many operations it performed, until
+    // `ops` have run; only the batches are timed, `reset()` runs between them.
+    template <typename Batch, typename Reset>
+    Timing time_batches(std::size_t ops, Batch &&batch, Reset &&reset)
+    {
+        Clock::duration elapsed{0};
+        std::size_t done = 0;
+        while (done < ops)
+        {
+            auto start = Clock::now();
+            done += batch();
+            elapsed += Clock::now() - start;
+            reset();
+        }
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        return {done, static_cast<double>(nanoseconds) / static_cast<double>(done)};
+    }
+
+    void report(const char *name, const Shape &shape, const Timing &timing)
+    {
+        std::cout << "bench=" << name
+                  << " layout=" << (shape.layout == BookLayout::tree ? "tree" : "ladder")
+                  << " depth=" << shape.depth
+                  << " orders_per_level=" << shape.orders_per_level
+                  << " ops=" << timing.ops
+                  << " ns_per_op=" << timing.ns_per_op << "\n";
+    }
+
+    // Operations per batch for cases that take orders out of the book, small
+    // enough that levels stay at least half full.
+    std::size_t batch_size_for(const Shape &shape)
+    {
+        return std::clamp<std::size_t>(shape.depth * shape.orders_per_level / 2, 1, 256);
+    }
+
+    void bench_add_passive(const Shape &shape, std::size_t ops)
+    {
+        Fixture fixture(shape);
+        std::mt19937 gen(1);
+        struct Add
+        {
+            OrderID id;
+            OrderSide side;
+            Price price;
+        };
+        std::vector<Add> adds(256);
+        auto draw = [&]() {
+            for (Add &add : adds)
+            {
+                add.id = fixture.next_id();
+                add.side = gen() % 2 ? OrderSide::buy : OrderSide::sell;
+                add.price = Fixture::price_of(add.side, fixture.passive_level(gen));
+            }
+        };
+        draw();
+
+        Timing timing = time_batches(ops,
+            [&]() {
+                for (const Add &add : adds)
+                    fixture.book().add_order(add.id, OrderType::good_till_cancel, add.side, add.price, 1);
+                return adds.size();
+            },
+            [&]() {
+                // Take the batch back out and draw the next one.
+                for (const Add &add : adds)
+                    fixture.book().cancel_order(add.id);
+                draw();
+            });
+        report("add_passive", shape, timing);
+    }
+
+    void bench_sweep(const Shape &shape, std::size_t ops)
+    {
+        Fixture fixture(shape);
+        Quantity side_quantity = static_cast<Quantity>(shape.depth * shape.orders_per_level);
+        Price through = Fixture::price_of(OrderSide::sell, shape.depth - 1);
+        // Each sweep rebuilds a whole side, so fewer are needed for a stable figure.
+        std::size_t sweeps = std::max<std::size_t>(20, ops / (shape.depth * shape.orders_per_level));
+        Timing timing = time_batches(sweeps,
+            [&]() {
+                fixture.book().add_order(fixture.next_id(), OrderType::immediate_or_cancel, OrderSide::buy,
+                                         through, side_quantity);
+                return std::size_t{1};
+            },
+            [&]() {
+                for (std::size_t level = 0; level < shape.depth; ++level)
+                {
+                    fixture.queue(OrderSide::sell, level).clear();
+                    for (std::size_t i = 0; i < shape.orders_per_level; ++i)
+                        fixture.rest(OrderSide::sell, level);
+                }
+            });
+        report("sweep", shape, timing);
+    }
+
+    enum class Position
+    {
+        front,
+        middle,
+        back
+    };
+
+    void bench_cancel(const char *name, Position position, const Shape &shape, std::size_t ops)
+    {
+        Fixture fixture(shape);
+        std::mt19937 gen(2);
+        std::size_t batch_size = batch_size_for(shape);
+        std::vector<std::pair<OrderSide, std::size_t>> levels;
+        std::vector<OrderID> targets;
+
+        auto pick = [&]() {
+            levels.clear();
+            targets.clear();
+            for (std::size_t i = 0; i < batch_size; ++i)
+            {
+                OrderSide side = gen() % 2 ? OrderSide::buy : OrderSide::sell;
+                std::size_t level = fixture.passive_level(gen);
+                std::deque<OrderID> &queue = fixture.queue(side, level);
+                if (queue.empty())
+                    continue;
+                std::size_t index = position == Position::front ? 0
+                                    : position == Position::back ? queue.size() - 1
+                                                                 : queue.size() / 2;
+                targets.push_back(queue[index]);
+                queue.erase(queue.begin() + static_cast<std::ptrdiff_t>(index));
+                levels.push_back({side, level});
+            }
+        };
+        pick();
+
+        Timing timing = time_batches(ops,
+            [&]() {
+                for (OrderID id : targets)
+                    fixture.book().cancel_order(id);
+                return targets.size();
+            },
+            [&]() {
+                // Refill the same levels; new orders join at the back, as they would in practice.
+                for (const auto &[side, level] : levels)
+                    fixture.rest(side, level);
+                pick();
+            });
+        report(name, shape, timing);
+    }
+
+    void bench_modify(const Shape &shape, std::size_t ops)
+    {
+        Fixture fixture(shape);
+        std::mt19937 gen(3);
+        std::uniform_int_distribution<Quantity> quantity_dist(1, 10);
+        struct Modify
+        {
+            OrderID id;
+            Price price;
+            Quantity quantity;
+        };
+        std::vector<Modify> modifies;
+        std::size_t batch_size = batch_size_for(shape);
+
+        auto pick = [&]() {
+            // Move the front order of a random level to another passive level on the same side.
+            modifies.clear();
+            for (std::size_t i = 0; i < batch_size; ++i)
+            {
+                OrderSide side = gen() % 2 ? OrderSide::buy : OrderSide::sell;
+                std::deque<OrderID> &from = fixture.queue(side, fixture.passive_level(gen));
+                if (from.empty())
+                    continue;
+                std::size_t to_level = fixture.passive_level(gen);
+                OrderID id = from.front();
+                from.pop_front();
+                fixture.queue(side, to_level).push_back(id);
+                modifies.push_back({id, Fixture::price_of(side, to_level), quantity_dist(gen)});
+            }
+        };
+        pick();
+
+        Timing timing = time_batches(ops,
+            [&]() {
+                for (const Modify &modify : modifies)
+                    fixture.book().modify_order(modify.id, modify.price, modify.quantity);
+                return modifies.size();
+            },
+            pick);
+        report("modify", shape, timing);
+    }
+
+    void bench_modify_reduce(const Shape &shape, std::size_t ops)
+    {
+        // Orders start large enough that no run of one-lot reduces can use one up.
+        const Quantity start_quantity = static_cast<Quantity>(ops + 1);
+        Fixture fixture(shape, start_quantity);
+        std::mt19937 gen(6);
+        struct Modify
+        {
+            OrderID id;
+            Price price;
+            Quantity quantity;
+        };
+        std::vector<Modify> modifies;
+        std::vector<Quantity> quantities;
+        std::size_t batch_size = batch_size_for(shape);
+
+        auto pick = [&]() {
+            // Shrink a random order of a random level by one lot; nothing moves in the queues.
+            modifies.clear();
+            for (std::size_t i = 0; i < batch_size; ++i)
+            {
+                OrderSide side = gen() % 2 ? OrderSide::buy : OrderSide::sell;
+                std::size_t level = fixture.passive_level(gen);
+                std::deque<OrderID> &queue = fixture.queue(side, level);
+                OrderID id = queue[gen() % queue.size()];
+                if (quantities.size() <= id)
+                    quantities.resize(id + 1, start_quantity);
+                modifies.push_back({id, Fixture::price_of(side, level), --quantities[id]});
+            }
+        };
+        pick();
+
+        Timing timing = time_batches(ops,
+            [&]() {
+                for (const Modify &modify : modifies)
+                    fixture.book().modify_order(modify.id, modify.price, modify.quantity);
+                return modifies.size();
+            },
+            pick);
+        report("modify_reduce", shape, timing);
+    }
+
+    void bench_fok_kill(const Shape &shape, std::size_t ops)
+    {
+        Fixture fixture(shape);
+        Quantity too_much = static_cast<Quantity>(shape.depth * shape.orders_per_level + 1);
+        Price through = Fixture::price_of(OrderSide::sell, shape.depth - 1);
+        Timing timing = time_batches(ops,
+            [&]() {
+                for (int i = 0; i < 256; ++i)
+                    fixture.book().add_order(fixture.next_id(), OrderType::fill_or_kill, OrderSide::buy,
+                                             through, too_much);
+                return std::size_t{256};
+            },
+            []() {});
+        report("fok_kill", shape, timing);
+    }
+
+    void bench_trade(const char *name, bool with_stops, const Shape &shape, std::size_t ops)
+    {
+        Fixture fixture(shape);
+        if (with_stops)
+        {
+            // Spread over `depth` prices beyond the far end of each side, out of reach of any trade below.
+            Price beyond = static_cast<Price>(shape.depth) + 1;
+            for (std::size_t i = 0; i < shape.depth * shape.orders_per_level; ++i)
+            {
+                Price offset = beyond + static_cast<Price>(i % shape.depth);
+                fixture.book().add_order(fixture.next_id(), OrderType::stop, OrderSide::buy, 0, 1,
+                                         mid_price + offset);
+                fixture.book().add_order(fixture.next_id(), OrderType::stop, OrderSide::sell, 0, 1,
+                                         mid_price - offset);
+            }
+        }
+        Price through = Fixture::price_of(OrderSide::sell, shape.depth - 1);
+        std::size_t batch_size = batch_size_for(shape);
+        Timing timing = time_batches(ops,
+            [&]() {
+                for (std::size_t i = 0; i < batch_size; ++i)
+                    fixture.book().add_order(fixture.next_id(), OrderType::immediate_or_cancel, OrderSide::buy,
+                                             through, 1);
+                return batch_size;
+            },
+            [&]() {
+                // Put back the lots the batch took, level by level from the touch.
+                std::size_t taken = batch_size;
+                for (std::size_t level = 0; taken > 0; ++level)
+                {
+                    std::deque<OrderID> &queue = fixture.queue(OrderSide::sell, level);
+                    std::size_t count = std::min(taken, queue.size());
+                    queue.erase(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(count));
+                    for (std::size_t i = 0; i < count; ++i)
+                        fixture.rest(OrderSide::sell, level);
+                    taken -= count;
+                }
+            });
+        report(name, shape, timing);
+    }
+
+    void bench_stop_trigger(const Shape &shape, std::size_t ops)
+    {
+        Fixture fixture(shape);
+        Price touch = Fixture::price_of(OrderSide::sell, 0);
+        Price limit = Fixture::price_of(OrderSide::buy, shape.depth - 1);
+        std::vector<OrderID> stops(256);
+        auto arm = [&]() {
+            for (OrderID &id : stops)
+            {
+                id = fixture.next_id();
+                fixture.book().add_order(id, OrderType::stop_limit, OrderSide::buy, limit, 1, touch);
+            }
+        };
+        arm();
+
+        Timing timing = time_batches(ops,
+            [&]() {
+                fixture.book().add_order(fixture.next_id(), OrderType::immediate_or_cancel, OrderSide::buy, touch, 1);
+                return stops.size();
+            },
+            [&]() {
+                // The stops now rest on the deepest bid; take them out and replace the lot that was traded.
+                for (OrderID id : stops)
+                    fixture.book().cancel_order(id);
+                fixture.queue(OrderSide::sell, 0).pop_front();
+                fixture.rest(OrderSide::sell, 0);
+                arm();
+            });
+        report("stop_trigger", shape, timing);
+    }
+
+    void bench_iceberg_refill(const Shape &shape, std::size_t ops)
+    {
+        // Inside the spread, and large enough that no run of the case uses one up.
+        Fixture fixture(shape);
+        for (std::size_t i = 0; i < shape.orders_per_level; ++i)
+            fixture.book().add_order(fixture.next_id(), OrderType::iceberg, OrderSide::sell, mid_price,
+                                     static_cast<Quantity>(ops + 256), 0, 1);
+        Timing timing = time_batches(ops,
+            [&]() {
+                for (int i = 0; i < 256; ++i)
+                    fixture.book().add_order(fixture.next_id(), OrderType::immediate_or_cancel, OrderSide::buy,
+                                             mid_price, 1);
+                return std::size_t{256};
+            },
+            []() {});
+        report("iceberg_refill", shape, timing);
+    }
+
+    void bench_get_levels(const char *name, std::size_t levels, const Shape &shape, std::size_t ops)
+    {
+        Fixture fixture(shape);
+        std::size_t checksum = 0;
+        Timing timing = time_batches(std::max<std::size_t>(100, ops / std::min(levels, shape.depth)),
+            [&]() {
+                for (int i = 0; i < 64; ++i)
+                    checksum += fixture.book().get_bids(levels).size() + fixture.book().get_asks(levels).size();
+                return std::size_t{64};
+            },
+            []() {});
+        // Keeps the calls from being optimized away.
+        if (checksum == 0)
+            std::cerr << "empty book\n";
+        report(name, shape, timing);
+    }
+
+    std::vector<std::size_t> parse_list(const std::string &text)
+    {
+        std::vector<std::size_t> values;
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ','))
+            values.push_back(std::max<std::size_t>(1, std::stoul(item)));
+        return values;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--layout")
+        {
+            if (value == "tree")
+                options.layouts = {BookLayout::tree};
+            else if (value == "ladder")
+                options.layouts = {BookLayout::ladder};
+        }
+        else if (arg == "--depth")
+            options.depths = parse_list(value);
+        else if (arg == "--orders")
+            options.orders_per_level = parse_list(value);
+        else if (arg == "--ops")
+            options.ops = std::stoul(value);
+        else if (arg == "--filter")
+            options.filter = value;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    auto selected = [&options](const char *name) {
+        return options.filter.empty() || std::string(name).find(options.filter) != std::string::npos;
+    };
+
+    for (BookLayout layout : options.layouts)
+    {
+        for (std::size_t depth : options.depths)
+        {
+            for (std::size_t orders_per_level : options.orders_per_level)
+            {
+                Shape shape{layout, depth, orders_per_level};
+                if (selected("add_passive"))
+                    bench_add_passive(shape, options.ops);
+                if (selected("sweep"))
+                    bench_sweep(shape, options.ops);
+                if (selected("cancel_front"))
+                    bench_cancel("cancel_front", Position::front, shape, options.ops);
+                if (selected("cancel_middle"))
+                    bench_cancel("cancel_middle", Position::middle, shape, options.ops);
+                if (selected("cancel_back"))
+                    bench_cancel("cancel_back", Position::back, shape, options.ops);
+                if (selected("modify"))
+                    bench_modify(shape, options.ops);
+                if (selected("modify_reduce"))
+                    bench_modify_reduce(shape, options.ops);
+                if (selected("fok_kill"))
+                    bench_fok_kill(shape, options.ops);
+                if (selected("trade"))
+                    bench_trade("trade", false, shape, options.ops);
+                if (selected("trade_with_stops"))
+                    bench_trade("trade_with_stops", true, shape, options.ops);
+                if (selected("stop_trigger"))
+                    bench_stop_trigger(shape, options.ops);
+                if (selected("iceberg_refill"))
+                    bench_iceberg_refill(shape, options.ops);
+                if (selected("get_levels_all"))
+                    bench_get_levels("get_levels_all", std::numeric_limits<std::size_t>::max(), shape, options.ops);
+                if (selected("get_levels_top10"))
+                    bench_get_levels("get_levels_top10", 10, shape, options.ops);
+            }
+        }
+    }
+}
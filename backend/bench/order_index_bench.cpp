@@ -0,0 +1,271 @@
+// Compares OrderIndex with the std::unordered_map<OrderID, OrderPointer> it
+// replaced in OrderBook, at book sizes of millions of live orders.
+//
+// For each size and id pattern both indexes are filled with `orders` ids and
+// then timed on:
+//   insert       filling the index from empty, without a reserve
+//   find_hit     looking up a random live id
+//   find_miss    looking up an id that is not present
+//   churn        erasing a random live id and inserting a fresh one, the
+//                steady state of a book whose size holds still
+//   erase        erasing every id in random order
+// Ids are either sequential, as tester and most clients generate them, or
+// random 64-bit values.
+//
+// Output is one line per case, in the same key=value form as the order book
+// benchmarks:
+//   bench=<case> index=<flat|unordered_map> ids=<sequential|random> orders=<n> ops=<n> ns_per_op=<x>
+// plus one memory line per index with the bytes it held once filled,
+// counted through its allocator.
+//
+// Options: --orders a,b,... (default 1000000,10000000), --ops N (timed
+// lookups and churn steps per case), --filter SUBSTRING.
+
+#include "order_index.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::vector<std::size_t> orders{1000000, 10000000};
+        std::size_t ops = 2000000;
+        std::string filter;
+    };
+
+    // Allocator that tallies the bytes std::unordered_map holds.
+    std::size_t allocated_bytes = 0;
+
+    template <typename T>
+    struct CountingAllocator
+    {
+        using value_type = T;
+
+        CountingAllocator() = default;
+        template <typename U>
+        CountingAllocator(const CountingAllocator<U> &) {}
+
+        T *allocate(std::size_t count)
+        {
+            allocated_bytes += count * sizeof(T);
+            return std::allocator<T>().allocate(count);
+        }
+
+        void deallocate(T *pointer, std::size_t count)
+        {
+            allocated_bytes -= count * sizeof(T);
+            std::allocator<T>().deallocate(pointer, count);
+        }
+
+        template <typename U>
+        bool operator==(const CountingAllocator<U> &) const { return true; }
+    };
+
+    using StdMap = std::unordered_map<OrderID, OrderPointer, std::hash<OrderID>, std::equal_to<OrderID>,
+                                      CountingAllocator<std::pair<const OrderID, OrderPointer>>>;
+
+    // Common interface over both indexes.
+    struct FlatAdapter
+    {
+        static constexpr const char *name = "flat";
+        OrderIndex index;
+
+        bool insert(OrderID id, OrderPointer order) { return index.insert(id, order); }
+        OrderPointer find(OrderID id) const { return index.find(id); }
+        bool erase(OrderID id) { return index.erase(id); }
+        std::size_t memory_bytes() const { return index.memory_bytes(); }
+    };
+
+    struct StdAdapter
+    {
+        static constexpr const char *name = "unordered_map";
+        StdMap map;
+
+        bool insert(OrderID id, OrderPointer order) { return map.emplace(id, order).second; }
+        OrderPointer find(OrderID id) const
+        {
+            auto it = map.find(id);
+            return it == map.end() ? nullptr : it->second;
+        }
+        bool erase(OrderID id) { return map.erase(id) != 0; }
+        std::size_t memory_bytes() const { return allocated_bytes; }
+    };
+
+    // Keeps lookup results alive so the timed loops are not optimized away.
+    volatile std::uintptr_t sink;
+
+    // Any distinct non-null value will do; the indexes never dereference it.
+    OrderPointer handle_for(OrderID id)
+    {
+        return reinterpret_cast<OrderPointer>(static_cast<std::uintptr_t>(id | 1) << 3);
+    }
+
+    struct Workload
+    {
+        const char *ids_name;
+        std::vector<OrderID> ids;        // filled in this order
+        std::vector<OrderID> fresh;      // inserted by churn, never in `ids`
+        std::vector<OrderID> misses;     // never inserted
+        std::vector<std::size_t> picks;  // random positions in `ids`
+    };
+
+    Workload make_workload(bool sequential, std::size_t orders, std::size_t ops)
+    {
+        std::mt19937_64 gen(sequential ? 1 : 2);
+        Workload workload;
+        workload.ids_name = sequential ? "sequential" : "random";
+        workload.ids.reserve(orders);
+        if (sequential)
+        {
+            for (std::size_t i = 0; i < orders; ++i)
+                workload.ids.push_back(i + 1);
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                workload.fresh.push_back(orders + 1 + i);
+                workload.misses.push_back(orders + ops + 1 + gen() % orders);
+            }
+        }
+        else
+        {
+            // The top bit splits ids from misses and fresh ids from both.
+            for (std::size_t i = 0; i < orders; ++i)
+                workload.ids.push_back(gen() >> 2);
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                workload.fresh.push_back((gen() >> 2) | (std::uint64_t{1} << 62));
+                workload.misses.push_back((gen() >> 2) | (std::uint64_t{1} << 63));
+            }
+            std::sort(workload.ids.begin(), workload.ids.end());
+            workload.ids.erase(std::unique(workload.ids.begin(), workload.ids.end()), workload.ids.end());
+            std::shuffle(workload.ids.begin(), workload.ids.end(), gen);
+        }
+        std::uniform_int_distribution<std::size_t> position(0, workload.ids.size() - 1);
+        for (std::size_t i = 0; i < ops; ++i)
+            workload.picks.push_back(position(gen));
+        return workload;
+    }
+
+    void report(const char *bench, const char *index, const Workload &workload, std::size_t ops,
+                Clock::duration elapsed)
+    {
+        std::cout << "bench=" << bench << " index=" << index << " ids=" << workload.ids_name
+                  << " orders=" << workload.ids.size() << " ops=" << ops
+                  << " ns_per_op=" << std::chrono::duration<double, std::nano>(elapsed).count() / ops << "\n";
+    }
+
+    template <typename Adapter, typename Selected>
+    void run(const Workload &workload, Selected &&selected)
+    {
+        auto index = std::make_unique<Adapter>();
+
+        auto start = Clock::now();
+        for (OrderID id : workload.ids)
+            index->insert(id, handle_for(id));
+        Clock::duration elapsed = Clock::now() - start;
+        if (selected("insert"))
+            report("insert", Adapter::name, workload, workload.ids.size(), elapsed);
+        if (selected("memory"))
+            std::cout << "bench=memory index=" << Adapter::name << " ids=" << workload.ids_name
+                      << " orders=" << workload.ids.size() << " bytes=" << index->memory_bytes()
+                      << " bytes_per_order=" << static_cast<double>(index->memory_bytes()) / workload.ids.size()
+                      << "\n";
+
+        if (selected("find_hit"))
+        {
+            start = Clock::now();
+            std::uintptr_t found = 0;
+            for (std::size_t pick : workload.picks)
+                found += reinterpret_cast<std::uintptr_t>(index->find(workload.ids[pick]));
+            sink = found;
+            report("find_hit", Adapter::name, workload, workload.picks.size(), Clock::now() - start);
+        }
+
+        if (selected("find_miss"))
+        {
+            start = Clock::now();
+            std::uintptr_t found = 0;
+            for (OrderID id : workload.misses)
+                found += reinterpret_cast<std::uintptr_t>(index->find(id));
+            sink = found;
+            report("find_miss", Adapter::name, workload, workload.misses.size(), Clock::now() - start);
+        }
+
+        // Churn replaces ids in a copy so the erase case still sees the original set.
+        std::vector<OrderID> live = workload.ids;
+        if (selected("churn"))
+        {
+            start = Clock::now();
+            for (std::size_t i = 0; i < workload.picks.size(); ++i)
+            {
+                OrderID &slot = live[workload.picks[i]];
+                index->erase(slot);
+                slot = workload.fresh[i];
+                index->insert(slot, handle_for(slot));
+            }
+            report("churn", Adapter::name, workload, workload.picks.size(), Clock::now() - start);
+        }
+
+        if (selected("erase"))
+        {
+            std::vector<OrderID> erase_order = live;
+            std::shuffle(erase_order.begin(), erase_order.end(), std::mt19937_64(3));
+            start = Clock::now();
+            for (OrderID id : erase_order)
+                index->erase(id);
+            report("erase", Adapter::name, workload, erase_order.size(), Clock::now() - start);
+        }
+    }
+
+    std::vector<std::size_t> parse_list(const std::string &text)
+    {
+        std::vector<std::size_t> values;
+        std::stringstream in(text);
+        std::string item;
+        while (std::getline(in, item, ','))
+            values.push_back(std::stoul(item));
+        return values;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--orders")
+            options.orders = parse_list(value);
+        else if (arg == "--ops")
+            options.ops = std::stoul(value);
+        else if (arg == "--filter")
+            options.filter = value;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    auto selected = [&options](const char *name) {
+        return options.filter.empty() || std::string(name).find(options.filter) != std::string::npos;
+    };
+
+    for (std::size_t orders : options.orders)
+    {
+        for (bool sequential : {true, false})
+        {
+            Workload workload = make_workload(sequential, orders, options.ops);
+            run<FlatAdapter>(workload, selected);
+            run<StdAdapter>(workload, selected);
+        }
+    }
+}
@@ -0,0 +1,177 @@
+#ifndef BINARY_PROTOCOL_HPP
+#define BINARY_PROTOCOL_HPP
+
+#include "byte_order.hpp"
+#include "order.hpp"
+#include "price_level.hpp"
+#include "symbol.hpp"
+#include "trade.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compact order-entry protocol spoken over WebSocket binary frames.
+//
+// A session opts in by offering `binary_subprotocol` in Sec-WebSocket-Protocol;
+// otherwise it speaks JSON. Every message is one frame with a fixed layout,
+// all integers little-endian, and starts with its BinaryMessage type byte.
+// Symbols take a 16-byte field but hold at most Symbol::max_length (15)
+// characters, zero-padded, so the last byte is always zero; an all-zero
+// symbol selects the default book.
+//
+// Requests (client -> server):
+//   new_order  40 bytes  type u8 | order_type u8 | side u8 | pad u8 | quantity u32
+//                        | id u64 | price i32 | aux u32 | symbol[16]
+//              aux is the stop price (i32) of a stop or stop_limit order, the
+//              display quantity of an iceberg and 0 for every other type
+//   cancel     32 bytes  type u8 | pad[7] | id u64 | symbol[16]
+//   modify     40 bytes  type u8 | pad[3] | quantity u32 | id u64 | price i32 | pad u32 | symbol[16]
+//   summary    24 bytes  type u8 | pad[3] | depth u32 (0 = all levels, as in JSON) | symbol[16]
+//   batch      8 + ...   type u8 | pad[3] | count u32 | count requests back to back
+//   subscribe  24 bytes  type u8 | pad[7] | symbol[16]
+//   unsubscribe 24 bytes type u8 | pad[7] | symbol[16]
+//
+// Responses (server -> client):
+//   execution_report  24 bytes  type u8 | request u8 | status u8 | pad u8 | filled u32
+//                               | id u64 | trade_count u32 | pad u32
+//   reject            16 + n    type u8 | request u8 | pad[2] | length u32 | id u64 | text[n]
+//   book_summary      16 + 12k  type u8 | pad[3] | bid_count u32 | ask_count u32 | pad u32
+//                               | k x (price i32 | quantity u32 | order_count u32), bids then asks
+//   batch_report      8 + ...   type u8 | pad[3] | count u32 | one response per batched request, in order
+//   snapshot, update  40 + 12k + 24t
+//                               type u8 | pad[3] | bid_count u32 | ask_count u32 | trade_count u32
+//                               | sequence u64 | symbol[16] | levels as in book_summary
+//                               | t x (bid_id u64 | ask_id u64 | price i32 | quantity u32)
+//
+// A subscription starts with a snapshot of the whole book; each update then
+// carries the new aggregate of every level that changed (quantity 0 removes
+// the level) and the trades since the previous update. Updates are numbered
+// per symbol; apply those with a sequence above the snapshot's.
+inline constexpr char binary_subprotocol[] = "orderbook.binary.v1";
+
+enum class BinaryMessage : std::uint8_t
+{
+    new_order = 0x01,
+    cancel = 0x02,
+    modify = 0x03,
+    summary = 0x04,
+    batch = 0x05,
+    subscribe = 0x06,
+    unsubscribe = 0x07,
+    execution_report = 0x81,
+    reject = 0x82,
+    book_summary = 0x83,
+    batch_report = 0x84,
+    snapshot = 0x85,
+    update = 0x86
+};
+
+inline constexpr std::size_t binary_symbol_size = 16;
+inline constexpr std::size_t binary_new_order_size = 40;
+inline constexpr std::size_t binary_cancel_size = 32;
+inline constexpr std::size_t binary_modify_size = 40;
+inline constexpr std::size_t binary_summary_size = 24;
+inline constexpr std::size_t binary_batch_header_size = 8;
+inline constexpr std::size_t binary_subscribe_size = 24;
+inline constexpr std::size_t binary_market_data_header_size = 40;
+inline constexpr std::size_t binary_trade_size = 24;
+inline constexpr std::size_t binary_execution_report_size = 24;
+inline constexpr std::size_t binary_reject_header_size = 16;
+inline constexpr std::size_t binary_book_summary_header_size = 16;
+inline constexpr std::size_t binary_level_size = 12;
+
+// Decoded request; only the fields used by `type` are meaningful.
+struct BinaryRequest
+{
+    BinaryMessage type = BinaryMessage::new_order;
+    Symbol symbol;
+    OrderID id = 0;
+    OrderType order_type = OrderType::good_till_cancel;
+    OrderSide side = OrderSide::buy;
+    Price price = 0;
+    Quantity quantity = 0;
+    Price stop_price = 0;          // new_order: stop and stop_limit
+    Quantity display_quantity = 0; // new_order: iceberg
+    std::uint32_t depth = 0;
+};
+
+// Decoded response; only the fields used by `type` are meaningful.
+struct BinaryResponse
+{
+    BinaryMessage type = BinaryMessage::execution_report;
+    BinaryMessage request = BinaryMessage::new_order;
+    Symbol symbol;
+    OrderID id = 0;
+    OrderStatus status = OrderStatus::open;
+    Quantity filled = 0;
+    std::uint32_t trade_count = 0;
+    std::string error;
+    OrderLevels bids;
+    OrderLevels asks;
+    std::uint64_t sequence = 0;        // snapshot, update
+    std::vector<Trade> trades;         // update
+    std::vector<BinaryResponse> items; // batch_report
+};
+
+// Decoding reads fields straight out of the received frame and throws
+// std::runtime_error on a truncated or unknown message.
+BinaryRequest decode_binary_request(const unsigned char *data, std::size_t size);
+// Calls `handler` with each request of a batch frame; returns the number decoded.
+template <typename Handler>
+std::size_t decode_binary_batch(const unsigned char *data, std::size_t size, Handler &&handler);
+BinaryResponse decode_binary_response(const unsigned char *data, std::size_t size);
+
+// Encoders append one complete message to `out`.
+// `stop_price` is only written for stop types and `display_quantity` only for icebergs.
+void encode_new_order(std::string &out, const Symbol &symbol, OrderID id, OrderType type,
+                      OrderSide side, Price price, Quantity quantity, Price stop_price = 0,
+                      Quantity display_quantity = 0);
+void encode_cancel(std::string &out, const Symbol &symbol, OrderID id);
+void encode_modify(std::string &out, const Symbol &symbol, OrderID id, Price price, Quantity quantity);
+void encode_summary(std::string &out, const Symbol &symbol, std::uint32_t depth);
+void encode_subscribe(std::string &out, BinaryMessage type, const Symbol &symbol);
+// Batches are a header followed by `count` messages appended with the encoders above.
+void encode_batch_header(std::string &out, BinaryMessage type, std::uint32_t count);
+
+// Size of a fixed-layout request, or 0 for types that are not single requests.
+std::size_t binary_request_size(BinaryMessage type);
+
+void encode_execution_report(std::string &out, BinaryMessage request, OrderID id, OrderStatus status,
+                             Quantity filled, std::uint32_t trade_count);
+void encode_reject(std::string &out, BinaryMessage request, OrderID id, std::string_view text);
+void encode_book_summary(std::string &out, const OrderLevels &bids, const OrderLevels &asks);
+// `type` is snapshot or update.
+void encode_market_data(std::string &out, BinaryMessage type, const Symbol &symbol, std::uint64_t sequence,
+                        const OrderLevels &bids, const OrderLevels &asks, const std::vector<Trade> &trades);
+
+// Status as spelled in JSON replies and tool output, e.g. "partially_filled".
+const char *order_status_name(OrderStatus status);
+// One-line human-readable rendering, used by the command-line tools.
+std::string describe_binary_response(const BinaryResponse &response);
+
+// === IMPLEMENTATION OF TEMPLATE FUNCTIONS ===
+
+template <typename Handler>
+std::size_t decode_binary_batch(const unsigned char *data, std::size_t size, Handler &&handler)
+{
+    if (size < binary_batch_header_size)
+        throw std::runtime_error("Truncated binary message");
+    std::uint32_t count = load_le<std::uint32_t>(data + 4);
+    std::size_t offset = binary_batch_header_size;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        if (offset >= size)
+            throw std::runtime_error("Truncated binary message");
+        std::size_t item_size = binary_request_size(static_cast<BinaryMessage>(data[offset]));
+        if (item_size == 0)
+            throw std::runtime_error("Unknown binary request type");
+        handler(decode_binary_request(data + offset, size - offset));
+        offset += item_size;
+    }
+    return count;
+}
+
+#endif // BINARY_PROTOCOL_HPP
@@ -0,0 +1,27 @@
+#ifndef BYTE_ORDER_HPP
+#define BYTE_ORDER_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+// Byte-order helpers; compilers reduce these to plain loads and stores on little-endian targets.
+template <typename T>
+T load_le(const unsigned char *data)
+{
+    using Unsigned = std::make_unsigned_t<T>;
+    Unsigned value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        value |= static_cast<Unsigned>(static_cast<Unsigned>(data[i]) << (8 * i));
+    return static_cast<T>(value);
+}
+
+template <typename T>
+void store_le(unsigned char *data, T value)
+{
+    using Unsigned = std::make_unsigned_t<T>;
+    Unsigned bits = static_cast<Unsigned>(value);
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        data[i] = static_cast<unsigned char>(bits >> (8 * i));
+}
+
+#endif // BYTE_ORDER_HPP
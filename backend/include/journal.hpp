@@ -0,0 +1,158 @@
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+#include "mapped_file.hpp"
+#include "order.hpp"
+#include "symbol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// When appended records are forced to stable storage.
+enum class JournalSync
+{
+    none,  // left to the OS; survives a process crash but not a power loss
+    group, // once per commit(), covering every record appended since the last one
+    every  // after every record
+};
+
+struct JournalConfig
+{
+    std::string directory;
+    std::size_t segment_size = 64 << 20; // bytes preallocated per segment file
+    JournalSync sync = JournalSync::group;
+    std::uint64_t snapshot_interval = 1000000; // records between book snapshots, 0 = only on shutdown
+};
+
+enum class JournalCommand : std::uint8_t
+{
+    add = 1,
+    cancel = 2,
+    modify = 3,
+    parameters = 4 // precedes a stop or iceberg add; never passed to replay handlers
+};
+
+struct JournalEntry
+{
+    std::uint64_t sequence = 0; // assigned by append
+    JournalCommand command = JournalCommand::add;
+    Symbol symbol;
+    OrderID id = 0;
+    OrderType type = OrderType::good_till_cancel;
+    OrderSide side = OrderSide::buy;
+    Price price = 0;
+    Quantity quantity = 0;
+    Price stop_price = 0;         // add: stop and stop_limit orders
+    Quantity display_quantity = 0; // add: icebergs
+};
+
+// Write-ahead log of accepted book commands.
+//
+// Records have a fixed 48-byte layout and are copied into preallocated,
+// memory-mapped segment files (journal-NNNNNN.log), so appending costs no
+// system call; durability is paid once per commit() under the group policy.
+// A record is valid only if its checksum matches, so the zero-filled tail of
+// a segment and a record torn by a crash both end the log. Opening a journal
+// recovers the write position and continues after the last valid record.
+//
+// A stop or iceberg add needs more fields than one record holds, so it is
+// written as a parameters record carrying its stop price and display
+// quantity, followed by the add itself in the same segment. Replay folds the
+// pair back into one entry; a parameters record whose add was lost is
+// dropped with it.
+class Journal
+{
+public:
+    static constexpr std::size_t record_size = 48;
+
+    explicit Journal(const JournalConfig &config);
+    ~Journal();
+
+    Journal(const Journal &) = delete;
+    Journal &operator=(const Journal &) = delete;
+
+    // Copies the entry into the log and returns its sequence number (that of
+    // the add record for a stop or iceberg add).
+    std::uint64_t append(JournalEntry entry);
+
+    // Group-commit point: makes everything appended so far durable per the sync policy.
+    void commit();
+
+    // Deletes segments holding only records up to `sequence`, once a
+    // snapshot covers them. The newest segment with a record is always kept.
+    void discard_through(std::uint64_t sequence);
+
+    const std::string &directory() const { return config_.directory; }
+    std::uint64_t last_sequence() const { return last_sequence_; }
+
+    // Calls `handler` with every valid entry after `after_sequence`, oldest
+    // first, and returns the last sequence seen (or `after_sequence`).
+    template <typename Handler>
+    static std::uint64_t replay(const std::string &directory, Handler &&handler, std::uint64_t after_sequence = 0);
+    // As replay, for a single segment file.
+    template <typename Handler>
+    static std::uint64_t replay_segment(const std::string &path, Handler &&handler, std::uint64_t after_sequence = 0);
+
+private:
+    static std::string segment_path(const std::string &directory, std::uint64_t index);
+    // Segment indexes present in `directory`, ascending.
+    static std::vector<std::uint64_t> list_segments(const std::string &directory);
+    // Sequence of the first record in a segment, 0 if it has none.
+    static std::uint64_t first_sequence(const std::string &directory, std::uint64_t index);
+    // Decodes the record at `data`; false if it is empty or corrupt.
+    static bool decode(const unsigned char *data, JournalEntry &entry);
+    // Copies a parameters record into the add that follows it.
+    static void merge_parameters(const JournalEntry &parameters, JournalEntry &entry);
+    static void encode(unsigned char *data, const JournalEntry &entry);
+
+    void open_segment(std::uint64_t index);
+    void close_segment();
+    void sync_range(std::size_t from, std::size_t to);
+
+    JournalConfig config_;
+    std::uint64_t segment_index_ = 0;
+    int fd_ = -1;
+    unsigned char *data_ = nullptr;
+    std::size_t offset_ = 0;
+    std::size_t synced_offset_ = 0;
+    std::uint64_t last_sequence_ = 0;
+};
+
+// === IMPLEMENTATION OF TEMPLATE FUNCTIONS ===
+
+template <typename Handler>
+std::uint64_t Journal::replay(const std::string &directory, Handler &&handler, std::uint64_t after_sequence)
+{
+    std::uint64_t last = after_sequence;
+    for (std::uint64_t index : list_segments(directory))
+        last = replay_segment(segment_path(directory, index), handler, last);
+    return last;
+}
+
+template <typename Handler>
+std::uint64_t Journal::replay_segment(const std::string &path, Handler &&handler, std::uint64_t after_sequence)
+{
+    std::uint64_t last = after_sequence;
+    JournalEntry entry;
+    JournalEntry parameters;
+    MappedFile segment(path);
+    for (std::size_t offset = 0; offset + record_size <= segment.size(); offset += record_size)
+    {
+        if (!decode(segment.data() + offset, entry))
+            break;
+        if (entry.command == JournalCommand::parameters)
+        {
+            parameters = entry;
+            continue;
+        }
+        merge_parameters(parameters, entry);
+        if (entry.sequence <= last)
+            continue;
+        handler(static_cast<const JournalEntry &>(entry));
+        last = entry.sequence;
+    }
+    return last;
+}
+
+#endif // JOURNAL_HPP
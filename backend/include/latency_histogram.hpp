@@ -0,0 +1,61 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// Log-linear histogram in the style of HdrHistogram: values below 128 get a
+// bucket each, and every power of two above that is split into 64 linear
+// sub-buckets, so any recorded value is reported to within 1/64 (about 1.6%)
+// of itself across the whole 64-bit range. Recording is a bit scan and an
+// increment; percentiles walk the fixed bucket array.
+class LatencyHistogram
+{
+public:
+    void record(std::uint64_t value)
+    {
+        ++counts_[bucket_index(value)];
+        ++count_;
+        sum_ += value;
+        max_ = std::max(max_, value);
+    }
+
+    // Adds every value recorded in `other`.
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t max() const { return max_; }
+    double mean() const;
+    // Smallest bucket bound that at least `percentile` percent of the values
+    // fall at or below, never above the exact maximum; 0 when empty.
+    std::uint64_t percentile(double percentile) const;
+
+private:
+    static constexpr unsigned sub_bucket_bits = 7;
+    static constexpr std::uint64_t sub_bucket_count = std::uint64_t{1} << sub_bucket_bits;
+    static constexpr std::uint64_t sub_bucket_half = sub_bucket_count / 2;
+    static constexpr std::size_t bucket_count =
+        sub_bucket_count + (64 - sub_bucket_bits) * sub_bucket_half;
+
+    static std::size_t bucket_index(std::uint64_t value)
+    {
+        if (value < sub_bucket_count)
+            return static_cast<std::size_t>(value);
+        unsigned shift = static_cast<unsigned>(std::bit_width(value)) - sub_bucket_bits;
+        return static_cast<std::size_t>(sub_bucket_count + (shift - 1) * sub_bucket_half +
+                                        ((value >> shift) - sub_bucket_half));
+    }
+    // Largest value that lands in bucket `index`.
+    static std::uint64_t bucket_upper_bound(std::size_t index);
+
+    std::array<std::uint64_t, bucket_count> counts_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t max_ = 0;
+    std::uint64_t sum_ = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
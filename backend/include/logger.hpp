@@ -1,31 +1,141 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
+
+enum class LogLevel : std::uint8_t
+{
+    debug,
+    info,
+    warning,
+    error,
+    off
+};
+
+// Levels below this are compiled out of Logger::event entirely.
+#ifndef ORDERBOOK_MIN_LOG_LEVEL
+#define ORDERBOOK_MIN_LOG_LEVEL 0
+#endif
+
+inline constexpr LogLevel compiled_log_level = static_cast<LogLevel>(ORDERBOOK_MIN_LOG_LEVEL);
+
+// Structured events emitted from the order entry and matching path.
+enum class LogEvent : std::uint8_t
+{
+    order_added,            // id
+    order_canceled,         // id
+    order_modified,         // id, new price, new total quantity
+    filled_by_modify,       // id
+    insufficient_liquidity, // fill-or-kill id
+    remainder_canceled,     // IOC/FOK id
+    trade,                  // aggressive id, resting id, price
+    iceberg_replenished,    // id, new visible quantity
+    stop_triggered          // id, stop price
+};
+
+// Fixed-size binary log record; formatting happens in format_log_record.
+struct LogRecord
+{
+    LogEvent event;
+    LogLevel level;
+    std::int64_t args[3];
+};
+
+std::string format_log_record(const LogRecord &record);
 
 class Logger
 {
 public:
+    explicit Logger(LogLevel level = LogLevel::debug) : level_(level) {}
     virtual ~Logger() = default;
+
+    // Free-form message for cold paths (startup, connection errors).
     virtual void log(const std::string &msg) = 0;
+
+    bool enabled(LogLevel level) const { return level >= level_; }
+    void set_level(LogLevel level) { level_ = level; }
+
+    // Hot-path logging. A level below compiled_log_level is removed at
+    // compile time, a level below the runtime level costs one compare; in
+    // neither case is anything formatted or any virtual function called.
+    template <LogLevel Level>
+    void event(LogEvent event, std::int64_t arg0 = 0, std::int64_t arg1 = 0, std::int64_t arg2 = 0)
+    {
+        if constexpr (Level >= compiled_log_level)
+        {
+            if (enabled(Level))
+                record({event, Level, {arg0, arg1, arg2}});
+        }
+    }
+
+protected:
+    // Formats synchronously by default; AsyncLogger defers it to its writer thread.
+    virtual void record(const LogRecord &record) { log(format_log_record(record)); }
+
+private:
+    LogLevel level_;
 };
 
 class ConsoleLogger : public Logger
 {
 public:
+    using Logger::Logger;
+
     void log(const std::string &msg) override
     {
-        std::cout << "[LOG] " << msg << std::endl;
+        std::cout << "[LOG] " << msg << '\n';
     }
 };
 
 class NullLogger : public Logger
 {
 public:
+    NullLogger() : Logger(LogLevel::off) {}
+
     void log(const std::string &) override {}
 };
 
+// Logger whose hot-path records are pushed onto a lock-free SPSC ring and
+// formatted by a background writer thread. Records must come from a single
+// producer thread (the thread that owns the book); when the ring is full
+// they are dropped and counted rather than blocking matching. Free-form
+// log() messages are written directly under the output lock, so they may
+// interleave with queued records out of order.
+class AsyncLogger : public Logger
+{
+public:
+    explicit AsyncLogger(std::ostream &out = std::cout, LogLevel level = LogLevel::info,
+                         std::size_t capacity = 65536);
+    ~AsyncLogger() override;
+
+    AsyncLogger(const AsyncLogger &) = delete;
+    AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+    void log(const std::string &msg) override;
+
+    std::uint64_t get_dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+protected:
+    void record(const LogRecord &record) override;
+
+private:
+    void run();
+    bool drain();
+
+    std::ostream &out_;
+    std::mutex out_mutex_;
+    SpscQueue<LogRecord> queue_;
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<bool> running_{true};
+    std::thread writer_;
+};
+
 inline Logger &get_default_logger()
 {
     static NullLogger default_logger;
@@ -0,0 +1,27 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file, for recovery paths that scan a
+// journal segment or snapshot once from front to back.
+class MappedFile
+{
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const unsigned char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const unsigned char *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,111 @@
+#ifndef MARKET_ANALYTICS_HPP
+#define MARKET_ANALYTICS_HPP
+
+#include "order.hpp"
+#include "price_level.hpp"
+#include "trade.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AnalyticsConfig
+{
+    std::size_t depth = 5;                            // levels per side in the imbalance
+    std::vector<std::uint32_t> windows{10, 60, 300};  // rolling windows, in seconds
+};
+
+// Trade figures over one rolling window; vwap and volatility are 0 without trades.
+struct WindowAnalytics
+{
+    std::uint32_t seconds = 0;
+    std::uint64_t trades = 0;
+    std::uint64_t volume = 0;
+    double vwap = 0;
+    // Realized: square root of the summed squared log returns between consecutive trades.
+    double volatility = 0;
+};
+
+// Point-in-time view of one book. The quote fields are only meaningful when
+// the sides they depend on are present.
+struct AnalyticsSnapshot
+{
+    bool has_bid = false;
+    bool has_ask = false;
+    OrderLevel best_bid{};
+    OrderLevel best_ask{};
+    Price spread = 0;
+    double mid = 0;
+    double microprice = 0;      // touch prices weighted by the opposite side's size
+    std::size_t depth = 0;      // levels per side summed below
+    std::uint64_t bid_depth_quantity = 0;
+    std::uint64_t ask_depth_quantity = 0;
+    double imbalance = 0;       // (bid - ask) / (bid + ask) over those levels, in [-1, 1]
+    Price last_price = 0;
+    std::uint64_t trades = 0;   // since the book was created
+    std::uint64_t volume = 0;
+    std::vector<WindowAnalytics> windows;
+};
+
+// Incremental quote and trade analytics for one book, fed with the level
+// changes and trades the book reports rather than recomputed from it.
+//
+// The best `depth` levels of each side are kept sorted best first, so a
+// level change costs at most a shift of `depth` entries. Only when a level
+// inside that range empties is the next one down unknown; needs_refill then
+// asks the owner for the book's best `depth` levels of that side.
+//
+// Trades land in a ring of one-second buckets covering the longest window,
+// so recording one is O(1) and a snapshot sums at most that many buckets.
+// Time is whatever monotonic nanosecond clock the caller passes in.
+class MarketAnalytics
+{
+public:
+    explicit MarketAnalytics(const AnalyticsConfig &config = {});
+
+    std::size_t depth() const { return depth_; }
+
+    // The new aggregate of a changed level, quantity 0 once it has emptied,
+    // as OrderBook::take_level_changes reports it.
+    void on_level(OrderSide side, const OrderLevel &level);
+    bool needs_refill(OrderSide side) const;
+    // Replaces a side's top levels with the book's best `depth` levels of it.
+    void refill(OrderSide side, const OrderLevels &levels);
+
+    void on_trade(const Trade &trade, std::uint64_t now_ns);
+
+    // Windows end at `now_ns`; buckets older than a window drop out of it.
+    AnalyticsSnapshot snapshot(std::uint64_t now_ns) const;
+
+private:
+    struct Side
+    {
+        OrderLevels levels;          // best first, at most depth_
+        std::uint64_t quantity = 0;  // sum over levels
+        bool stale = false;          // a level inside the range emptied
+    };
+
+    struct Bucket
+    {
+        std::uint64_t second = empty_bucket;
+        std::uint64_t trades = 0;
+        std::uint64_t volume = 0;
+        double notional = 0;
+        double squared_returns = 0;
+    };
+
+    static constexpr std::uint64_t empty_bucket = ~std::uint64_t{0};
+
+    Side &side_of(OrderSide side) { return side == OrderSide::buy ? bids_ : asks_; }
+    const Side &side_of(OrderSide side) const { return side == OrderSide::buy ? bids_ : asks_; }
+
+    std::size_t depth_;
+    std::vector<std::uint32_t> windows_;
+    Side bids_;
+    Side asks_;
+    std::vector<Bucket> buckets_; // indexed by second modulo the longest window
+    Price last_price_ = 0;
+    std::uint64_t trades_ = 0;
+    std::uint64_t volume_ = 0;
+};
+
+#endif // MARKET_ANALYTICS_HPP
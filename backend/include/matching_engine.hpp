@@ -4,117 +4,266 @@
 #include "order.hpp"
 #include "trade.hpp"
 #include "logger.hpp"
-#include <unordered_map>
-#include <deque>
+#include "price_level.hpp"
+#include <algorithm>
 #include <functional>
-#include <map>
-
-using OrderPointer = std::shared_ptr<Order>;
-using OrderPointers = std::deque<OrderPointer>;
+#include <type_traits>
 
+// Price-time matching of an incoming order against one side of a book.
+//
+// The engine is a long-lived member of its book. Side effects are reported
+// to the Listener through statically bound hooks, so no callback is type
+// erased and every order is handled by pointer without a second lookup:
+//
+//   void on_trade(const Trade &trade);
+//   void on_resting_filled(OrderPointer order); // left its level fully filled
+//   void on_order_killed(OrderPointer order);   // IOC/FOK remainder canceled
+//   void on_level_changed(OrderSide side, Price price); // once per level traded against
+//
+// match_order dispatches once on the order type; the matching kernel is
+// instantiated per (order type, opposite side) so the level and fill loops
+// carry no side or type branches. Levels holding icebergs take a separate
+// loop that refills an exhausted slice by moving the same record to the
+// back of the queue; every other level keeps the plain fill loop. The
+// aggressor's side is implied by the opposite book's key_compare: std::less
+// (asks) means a buy, std::greater (bids) a sell.
+template <typename Listener>
 class MatchingEngine
 {
 public:
-    MatchingEngine(std::unordered_map<OrderID, OrderPointer> &order_lookup,
-                   Trades &trade_history,
-                   std::function<void(OrderID)> cancel_func,
-                   Logger &logger);
+    MatchingEngine(Listener &listener, Logger &logger);
 
+    // `opposite_book` must be the side the order trades against.
     template <typename OppositeMap>
     void match_order(OrderPointer aggressive_order, OppositeMap &opposite_book);
 
 private:
+    template <OrderType Type, typename OppositeMap>
+    void match(OrderPointer aggressive_order, OppositeMap &opposite_book);
+
+    // A level is marketable unless it sorts strictly after the limit price.
+    template <typename Compare>
+    static bool is_price_acceptable(Price limit_price, Price level_price);
+
     template <typename OppositeMap>
     bool has_sufficient_liquidity(OrderPointer aggressive_order, const OppositeMap &opposite_book) const;
 
-    bool is_price_acceptable(OrderPointer aggressive_order, Price best_price) const;
-    void process_price_level(OrderPointer aggressive_order, OrderPointers &order_list);
-
     template <typename OppositeMap>
     Quantity get_available_quantity(OrderPointer aggressive_order, const OppositeMap &opposite_book) const;
 
-    void execute_trade(OrderPointer aggressive_order, OrderPointer resting_order);
+    template <bool AggressiveBuy>
+    void process_price_level(OrderPointer aggressive_order, PriceLevel &level);
 
-    std::unordered_map<OrderID, OrderPointer> &order_lookup_;
-    Trades &trade_history_;
-    std::function<void(OrderID)> cancel_order_;
+    template <bool AggressiveBuy>
+    void process_iceberg_level(OrderPointer aggressive_order, PriceLevel &level);
+
+    // Trades up to `available` of the resting order.
+    template <bool AggressiveBuy>
+    Quantity execute_trade(OrderPointer aggressive_order, OrderPointer resting_order, Quantity available);
+
+    Listener &listener_;
     Logger &logger_;
 };
 
 // === IMPLEMENTATION OF TEMPLATE FUNCTIONS ===
 
+template <typename Listener>
+MatchingEngine<Listener>::MatchingEngine(Listener &listener, Logger &logger)
+    : listener_(listener), logger_(logger) {}
+
+template <typename Listener>
 template <typename OppositeMap>
-void MatchingEngine::match_order(OrderPointer aggressive_order, OppositeMap &opposite_book)
+void MatchingEngine<Listener>::match_order(OrderPointer aggressive_order, OppositeMap &opposite_book)
 {
-    if (aggressive_order->get_type() == OrderType::fill_or_kill &&
-        !has_sufficient_liquidity(aggressive_order, opposite_book))
+    switch (aggressive_order->get_type())
     {
-        logger_.log("Insufficient liquidity for fill_or_kill order " +
-                    std::to_string(aggressive_order->get_id()));
-        cancel_order_(aggressive_order->get_id());
-        return;
+    case OrderType::good_till_cancel:
+        match<OrderType::good_till_cancel>(aggressive_order, opposite_book);
+        break;
+    case OrderType::immediate_or_cancel:
+        match<OrderType::immediate_or_cancel>(aggressive_order, opposite_book);
+        break;
+    case OrderType::fill_or_kill:
+        match<OrderType::fill_or_kill>(aggressive_order, opposite_book);
+        break;
+    case OrderType::iceberg:
+        // The whole quantity is available to match; only a resting iceberg hides any.
+        match<OrderType::good_till_cancel>(aggressive_order, opposite_book);
+        break;
+    case OrderType::stop:
+    case OrderType::stop_limit:
+        break; // the book triggers stops into one of the types above first
+    }
+}
+
+template <typename Listener>
+template <OrderType Type, typename OppositeMap>
+void MatchingEngine<Listener>::match(OrderPointer aggressive_order, OppositeMap &opposite_book)
+{
+    using Compare = typename OppositeMap::key_compare;
+    constexpr bool aggressive_buy = std::is_same_v<Compare, std::less<Price>>;
+
+    if constexpr (Type == OrderType::fill_or_kill)
+    {
+        if (!has_sufficient_liquidity(aggressive_order, opposite_book))
+        {
+            logger_.event<LogLevel::debug>(LogEvent::insufficient_liquidity,
+                                           static_cast<std::int64_t>(aggressive_order->get_id()));
+            listener_.on_order_killed(aggressive_order);
+            return;
+        }
     }
 
+    const Price limit_price = aggressive_order->get_price();
     while (!opposite_book.empty() && aggressive_order->get_remaining_quantity() > 0)
     {
         auto best_it = opposite_book.begin();
-        Price best_price = best_it->first;
-        if (!is_price_acceptable(aggressive_order, best_price))
-        {
-            if (aggressive_order->get_type() == OrderType::immediate_or_cancel ||
-                aggressive_order->get_type() == OrderType::fill_or_kill)
-            {
-                logger_.log("Price not acceptable for order " +
-                            std::to_string(aggressive_order->get_id()));
-                cancel_order_(aggressive_order->get_id());
-            }
+        if (!is_price_acceptable<Compare>(limit_price, best_it->first))
             break;
-        }
-        auto &order_list = best_it->second;
-        process_price_level(aggressive_order, order_list);
-        if (order_list.empty())
+
+        auto &level = best_it->second;
+        process_price_level<aggressive_buy>(aggressive_order, level);
+        listener_.on_level_changed(aggressive_buy ? OrderSide::sell : OrderSide::buy, best_it->first);
+        if (level.empty())
             opposite_book.erase(best_it);
     }
 
-    if (aggressive_order->get_type() == OrderType::immediate_or_cancel &&
-        aggressive_order->get_remaining_quantity() > 0)
+    if constexpr (Type != OrderType::good_till_cancel)
     {
-        aggressive_order->cancel();
-        logger_.log("ImmediateOrCancel order " +
-                    std::to_string(aggressive_order->get_id()) +
-                    " canceled due to remaining quantity");
-        cancel_order_(aggressive_order->get_id());
+        if (aggressive_order->get_remaining_quantity() > 0)
+        {
+            logger_.event<LogLevel::debug>(LogEvent::remainder_canceled,
+                                           static_cast<std::int64_t>(aggressive_order->get_id()));
+            listener_.on_order_killed(aggressive_order);
+        }
     }
 }
 
+template <typename Listener>
+template <typename Compare>
+bool MatchingEngine<Listener>::is_price_acceptable(Price limit_price, Price level_price)
+{
+    return !Compare{}(limit_price, level_price);
+}
+
+template <typename Listener>
 template <typename OppositeMap>
-bool MatchingEngine::has_sufficient_liquidity(OrderPointer aggressive_order, const OppositeMap &opposite_book) const
+bool MatchingEngine<Listener>::has_sufficient_liquidity(OrderPointer aggressive_order, const OppositeMap &opposite_book) const
 {
     Quantity available = get_available_quantity(aggressive_order, opposite_book);
     return available >= aggressive_order->get_remaining_quantity();
 }
 
+// Sums level aggregates best-first, stopping at the first level that is not
+// marketable or as soon as the order's remaining quantity is covered, so the
+// cost is bounded by the number of levels touched rather than resting orders.
+template <typename Listener>
 template <typename OppositeMap>
-Quantity MatchingEngine::get_available_quantity(OrderPointer aggressive_order, const OppositeMap &opposite_book) const
+Quantity MatchingEngine<Listener>::get_available_quantity(OrderPointer aggressive_order, const OppositeMap &opposite_book) const
 {
+    using Compare = typename OppositeMap::key_compare;
+
+    const Price limit_price = aggressive_order->get_price();
+    Quantity needed = aggressive_order->get_remaining_quantity();
     Quantity total = 0;
     for (auto it = opposite_book.begin(); it != opposite_book.end(); ++it)
     {
-        Price level_price = it->first;
-        bool level_matches = (aggressive_order->get_side() == OrderSide::buy)
-                                 ? (aggressive_order->get_price() >= level_price)
-                                 : (aggressive_order->get_price() <= level_price);
-        if (!level_matches)
+        if (!is_price_acceptable<Compare>(limit_price, it->first))
             break;
 
-        for (const auto &order : it->second)
+        total += it->second.total_quantity + it->second.hidden_quantity;
+        if (total >= needed)
+            return total;
+    }
+    return total;
+}
+
+// Processes trades at a specific price level
+template <typename Listener>
+template <bool AggressiveBuy>
+void MatchingEngine<Listener>::process_price_level(OrderPointer aggressive_order, PriceLevel &level)
+{
+    if (level.iceberg_count != 0)
+    {
+        process_iceberg_level<AggressiveBuy>(aggressive_order, level);
+        return;
+    }
+
+    while (!level.empty() && aggressive_order->get_remaining_quantity() > 0)
+    {
+        OrderPointer resting_order = level.front();
+        level.reduce(execute_trade<AggressiveBuy>(aggressive_order, resting_order,
+                                                  resting_order->get_remaining_quantity()));
+
+        if (resting_order->get_remaining_quantity() == 0)
         {
-            total += order->get_remaining_quantity();
-            if (total >= aggressive_order->get_remaining_quantity())
-                return total;
+            level.pop_front();
+            listener_.on_resting_filled(resting_order);
         }
     }
-    return total;
+}
+
+// As process_price_level, for a level holding at least one iceberg. An
+// iceberg trades only its visible slice; once that is gone and a reserve is
+// left, the record is unlinked, given a fresh slice and queued again at the
+// back, losing its time priority without any allocation.
+template <typename Listener>
+template <bool AggressiveBuy>
+void MatchingEngine<Listener>::process_iceberg_level(OrderPointer aggressive_order, PriceLevel &level)
+{
+    while (!level.empty() && aggressive_order->get_remaining_quantity() > 0)
+    {
+        OrderPointer resting_order = level.front();
+        if (!resting_order->is_iceberg())
+        {
+            level.reduce(execute_trade<AggressiveBuy>(aggressive_order, resting_order,
+                                                      resting_order->get_remaining_quantity()));
+        }
+        else
+        {
+            Quantity traded = execute_trade<AggressiveBuy>(aggressive_order, resting_order,
+                                                           resting_order->get_visible_quantity());
+            resting_order->consume_visible(traded);
+            level.reduce(traded);
+        }
+
+        if (resting_order->get_remaining_quantity() == 0)
+        {
+            level.pop_front();
+            listener_.on_resting_filled(resting_order);
+        }
+        else if (resting_order->get_visible_quantity() == 0)
+        {
+            level.pop_front();
+            resting_order->replenish();
+            level.push_back(resting_order);
+            logger_.event<LogLevel::debug>(LogEvent::iceberg_replenished,
+                                           static_cast<std::int64_t>(resting_order->get_id()),
+                                           resting_order->get_visible_quantity());
+        }
+    }
+}
+
+// Executes a trade between an aggressive order and a resting order and returns the traded quantity.
+template <typename Listener>
+template <bool AggressiveBuy>
+Quantity MatchingEngine<Listener>::execute_trade(OrderPointer aggressive_order, OrderPointer resting_order,
+                                                 Quantity available)
+{
+    Quantity trade_quantity = std::min(aggressive_order->get_remaining_quantity(), available);
+    aggressive_order->fill(trade_quantity);
+    resting_order->fill(trade_quantity);
+
+    Price execution_price = resting_order->get_price();
+    OrderPointer bid_order = AggressiveBuy ? aggressive_order : resting_order;
+    OrderPointer ask_order = AggressiveBuy ? resting_order : aggressive_order;
+
+    listener_.on_trade(Trade(bid_order->get_id(), ask_order->get_id(), execution_price, trade_quantity));
+    logger_.event<LogLevel::debug>(LogEvent::trade,
+                                   static_cast<std::int64_t>(aggressive_order->get_id()),
+                                   static_cast<std::int64_t>(resting_order->get_id()),
+                                   execution_price);
+    return trade_quantity;
 }
 
 #endif // MATCHING_ENGINE_HPP
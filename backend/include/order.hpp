@@ -5,20 +5,27 @@
 #include <cstdint>
 #include <stdexcept>
 
-enum class OrderType
+// Stops wait in the book's StopBook until a trade reaches their stop price;
+// a stop then becomes an immediate_or_cancel order at any price and a
+// stop_limit a good_till_cancel order at its limit. An iceberg rests like a
+// good_till_cancel order but shows at most its display quantity at a time.
+enum class OrderType : std::uint8_t
 {
     good_till_cancel,
     immediate_or_cancel,
-    fill_or_kill
+    fill_or_kill,
+    stop,
+    stop_limit,
+    iceberg
 };
 
-enum class OrderSide
+enum class OrderSide : std::uint8_t
 {
     buy,
     sell
 };
 
-enum class OrderStatus
+enum class OrderStatus : std::uint8_t
 {
     open,
     partially_filled,
@@ -30,6 +37,8 @@ using Price = std::int32_t;
 using Quantity = std::uint32_t;
 using OrderID = std::uint64_t;
 
+class OrderQueue;
+
 class Order
 {
 public:
@@ -45,19 +54,53 @@ public:
     OrderStatus get_status() const;
     auto get_timestamp() const;
 
+    // Inline: checked on every level push and erase.
+    bool is_stop() const { return type_ == OrderType::stop || type_ == OrderType::stop_limit; }
+    bool is_iceberg() const { return type_ == OrderType::iceberg; }
+    Price get_stop_price() const;
+    Quantity get_display_quantity() const;
+    // An iceberg's current slice; the whole remaining quantity for any other order.
+    Quantity get_visible_quantity() const;
+    Quantity get_hidden_quantity() const;
+
+    // Set right after construction for the types that use them.
+    void set_stop_price(Price stop_price);
+    void set_display_quantity(Quantity display_quantity);
+
     void cancel();
     void modify(Price new_price, Quantity new_quantity);
     void fill(Quantity quantity);
+    // Takes `quantity` just filled off an iceberg's visible slice.
+    void consume_visible(Quantity quantity);
+    // Shows a fresh slice of an iceberg from its reserve.
+    void replenish();
+    // Turns a stop whose stop price was reached into the order it stands for.
+    void trigger();
 
 private:
     OrderID id_;
     OrderType type_;
     OrderSide side_;
+    OrderStatus status_;
     Price price_;
     Quantity initial_quantity_;
     Quantity remaining_quantity_;
+    Quantity display_quantity_ = 0;
+    Quantity visible_quantity_ = 0;
+    Price stop_price_ = 0;
     std::chrono::steady_clock::time_point timestamp_;
-    OrderStatus status_;
+
+    // Position in the price level's OrderQueue while the order is resting.
+    friend class OrderQueue;
+    Order *prev_ = nullptr;
+    Order *next_ = nullptr;
 };
 
+// With one-byte enums the stop and iceberg fields fit without growing the
+// record past one cache line.
+static_assert(sizeof(Order) == 64);
+
+// Handle to an Order record owned by the book's OrderPool.
+using OrderPointer = Order *;
+
 #endif // ORDER_HPP
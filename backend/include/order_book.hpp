@@ -3,41 +3,145 @@
 
 #include "order.hpp"
 #include "trade.hpp"
+#include "trade_tape.hpp"
 #include "matching_engine.hpp"
+#include "order_index.hpp"
+#include "order_pool.hpp"
+#include "price_ladder.hpp"
+#include "stop_book.hpp"
 #include "logger.hpp"
+#include <limits>
 #include <map>
-#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
 
-struct OrderLevel {
-    Price price;
-    Quantity quantity;
+// How a book stores its price levels.
+enum class BookLayout
+{
+    tree,  // std::map per side; any price range
+    ladder // PriceLadder per side; fast for prices clustered around the mid
 };
 
-using OrderLevels = std::vector<OrderLevel>;
+struct BookConfig
+{
+    BookLayout layout = BookLayout::tree;
+    Price center_price = 0;             // ladder: initial window center
+    Price tick_size = 1;                // ladder: every price must be a multiple of this
+    std::size_t ladder_levels = 4096;   // ladder: initial window size per side
+    std::size_t ladder_max_levels = std::size_t{1} << 20; // ladder: widest window per side; farther prices are rejected
+    std::size_t order_capacity = 4096;  // Order records preallocated in the pool
+    std::size_t trade_capacity = 65536; // most recent trades kept on the tape
+};
+
+// One resting or pending stop order as captured by a snapshot.
+struct RestingOrder
+{
+    OrderID id;
+    OrderType type;
+    OrderSide side;
+    Price price;
+    Quantity initial_quantity;
+    Quantity remaining_quantity;
+    Price stop_price = 0;         // stop, stop_limit
+    Quantity display_quantity = 0; // iceberg
+    Quantity visible_quantity = 0; // iceberg: what is left of its current slice
+};
 
 class OrderBook
 {
 public:
-    OrderBook(Logger *logger = nullptr);
-    const Trades &get_trade_history() const;
+    OrderBook(Logger *logger = nullptr, const BookConfig &config = {});
+    OrderBook(const OrderBook &) = delete;
+    OrderBook &operator=(const OrderBook &) = delete;
+
+    // Bounded view of the most recent trades; consumers that need every
+    // trade drain the tape with their own cursor.
+    const TradeTape &get_trade_history() const;
 
-    OrderLevels get_bids() const;
-    OrderLevels get_asks() const;
+    // Aggregated levels best-first, optionally limited to the first `depth` levels.
+    OrderLevels get_bids(std::size_t depth = std::numeric_limits<std::size_t>::max()) const;
+    OrderLevels get_asks(std::size_t depth = std::numeric_limits<std::size_t>::max()) const;
+    OrderPoolStats get_pool_stats() const;
+    // Increases whenever any price level changes, so equal versions mean equal depth.
+    std::uint64_t get_version() const { return version_; }
 
-    OrderPointer add_order(OrderID id, OrderType type, OrderSide side, Price price, Quantity quantity);
+    // Returns the status of the incoming order once matching is done; a
+    // stop that has not triggered is open. `stop_price` is only read for
+    // stop and stop_limit orders, whose `price` is the limit a stop_limit
+    // trades at and is ignored for a stop; `display_quantity` is only read
+    // for icebergs. Stops trigger on trades made after they arrive, and any
+    // call that trades runs the stops it triggers before returning.
+    OrderStatus add_order(OrderID id, OrderType type, OrderSide side, Price price, Quantity quantity,
+                          Price stop_price = 0, Quantity display_quantity = 0);
     void cancel_order(OrderID id);
+    // A reduce at the same price shrinks the order in place and keeps its
+    // queue position; any other change cancels and re-adds it at the back.
+    // Icebergs always take the second path; pending stops cannot be modified.
     void modify_order(OrderID id, Price new_price, Quantity new_total_quantity);
 
+    // Market-data support. While tracking is on, every level whose aggregate
+    // changes is remembered; take_level_changes reports each one once, best
+    // first per side, with its current aggregate (quantity 0 if it emptied).
+    void set_level_tracking(bool enabled);
+    void take_level_changes(OrderLevels &bids, OrderLevels &asks);
+
+    // Snapshot support. get_resting_orders lists every resting order in
+    // price-time order: bids best first, then asks best first, each level
+    // front to back, followed by the pending stops in trigger order.
+    // restore_orders rebuilds an empty book from such a list without
+    // matching, appending each run of equal prices to its level in one step
+    // and rebuilding the id index as it goes.
+    std::vector<RestingOrder> get_resting_orders() const;
+    void restore_orders(const std::vector<RestingOrder> &orders);
+
 private:
+    friend class MatchingEngine<OrderBook>;
+
+    // MatchingEngine hooks
+    void on_trade(const Trade &trade);
+    void on_resting_filled(OrderPointer order);
+    void on_order_killed(OrderPointer order);
+    void on_level_changed(OrderSide side, Price price);
+
+    template <typename BidLevels, typename AskLevels>
+    struct Sides
+    {
+        BidLevels bids;
+        AskLevels asks;
+    };
+
+    using TreeSides = Sides<std::map<Price, PriceLevel, std::greater<Price>>,
+                            std::map<Price, PriceLevel, std::less<Price>>>;
+    using LadderSides = Sides<PriceLadder<PriceLevel, std::greater<Price>>,
+                              PriceLadder<PriceLevel, std::less<Price>>>;
+
+    static std::variant<TreeSides, LadderSides> make_sides(const BookConfig &config);
+
+    template <typename BookSides>
+    OrderStatus match_and_rest(BookSides &sides, OrderPointer order);
+    template <typename BookSides>
+    void restore_levels(BookSides &sides, const std::vector<RestingOrder> &orders);
+
     OrderPointer find_order(OrderID id);
+    // Whether an order at `price` could rest on its side; always true for
+    // the tree layout, bounded by the window limit for ladders.
+    bool can_rest_at(OrderSide side, Price price) const;
+    // Matches the stops that trades have triggered until no more trigger.
+    void trigger_stops();
     void cancel_order_impl(OrderPointer order);
     void remove_order_impl(OrderPointer order);
 
-    std::map<Price, OrderPointers, std::greater<Price>> bids_;
-    std::map<Price, OrderPointers, std::less<Price>> asks_;
-    std::unordered_map<OrderID, OrderPointer> order_lookup_;
-    Trades trade_history_;
+    OrderPool order_pool_;
+    std::variant<TreeSides, LadderSides> sides_;
+    OrderIndex order_lookup_; // resting orders and pending stops
+    StopBook stop_book_;
+    TradeTape trade_tape_;
+    std::uint64_t version_ = 1;
+    bool level_tracking_ = false;
+    std::vector<std::pair<OrderSide, Price>> changed_levels_;
     Logger &logger_;
+    MatchingEngine<OrderBook> matching_engine_;
 };
 
 #endif // ORDER_BOOK_HPP
@@ -0,0 +1,82 @@
+#ifndef ORDER_INDEX_HPP
+#define ORDER_INDEX_HPP
+
+#include "order.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Flat open-addressing map from order id to resting order, replacing
+// std::unordered_map<OrderID, OrderPointer> in OrderBook.
+//
+// Entries are stored inline in one power-of-two array of 16-byte slots and
+// probed linearly, so a lookup touches one or two adjacent cache lines and
+// inserting or erasing never allocates. Ids are spread by Fibonacci hashing
+// (multiply by 2^64/phi, keep the top bits), which maps the dense,
+// increasing ids most clients generate onto evenly spaced slots. Erasure
+// shifts later entries of the probe run back instead of leaving tombstones,
+// so probe lengths depend only on the live entries. The table doubles when
+// it would pass max_load, so memory is between 16/max_load and 32/max_load
+// bytes per live order and never shrinks.
+class OrderIndex
+{
+public:
+    // Fraction of slots that may be occupied before the table doubles.
+    static constexpr double max_load = 0.75;
+
+    explicit OrderIndex(std::size_t capacity = 0);
+
+    // Null if `id` is not indexed.
+    OrderPointer find(OrderID id) const
+    {
+        for (std::size_t i = home(id);; i = (i + 1) & mask_)
+        {
+            const Slot &slot = slots_[i];
+            if (slot.order == nullptr)
+                return nullptr;
+            if (slot.id == id)
+                return slot.order;
+        }
+    }
+
+    bool contains(OrderID id) const { return find(id) != nullptr; }
+
+    // Returns false, leaving the index unchanged, if `id` is already present.
+    bool insert(OrderID id, OrderPointer order);
+    // Returns false if `id` was not indexed.
+    bool erase(OrderID id);
+
+    // Sizes the table for `count` entries without further growth.
+    void reserve(std::size_t count);
+    void clear();
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    std::size_t bucket_count() const { return slots_.size(); }
+    std::size_t memory_bytes() const { return slots_.size() * sizeof(Slot); }
+
+private:
+    // An empty slot has a null order; ids themselves may take any value.
+    struct Slot
+    {
+        OrderID id = 0;
+        OrderPointer order = nullptr;
+    };
+
+    std::size_t home(OrderID id) const
+    {
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(id) * 0x9e3779b97f4a7c15ull) >> shift_);
+    }
+
+    static std::size_t slots_for(std::size_t count);
+    void rehash(std::size_t slot_count);
+
+    std::vector<Slot> slots_;
+    std::size_t mask_ = 0;
+    unsigned shift_ = 64;
+    std::size_t size_ = 0;
+    std::size_t grow_at_ = 0; // size at which the next insert doubles the table
+};
+
+#endif // ORDER_INDEX_HPP
@@ -0,0 +1,55 @@
+#ifndef ORDER_POOL_HPP
+#define ORDER_POOL_HPP
+
+#include "order.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+struct OrderPoolStats
+{
+    std::size_t capacity;        // records allocated across all slabs
+    std::size_t in_use;          // records currently handed out
+    std::size_t high_water_mark; // largest in_use seen so far
+    std::size_t slabs;           // number of slab allocations made
+};
+
+// Slab allocator for Order records owned by an OrderBook.
+//
+// Records are carved out of fixed-size slabs and recycled through an
+// intrusive free list, so once the pool has grown to the working set no
+// further heap allocation happens. Handles are plain Order pointers and
+// stay valid until released; slabs are never freed before the pool.
+class OrderPool
+{
+public:
+    explicit OrderPool(std::size_t slab_size = 4096);
+
+    OrderPool(const OrderPool &) = delete;
+    OrderPool &operator=(const OrderPool &) = delete;
+
+    Order *acquire(OrderID id, OrderType type, OrderSide side, Price price, Quantity quantity);
+    void release(Order *order);
+
+    // Grows the pool until at least `capacity` records exist.
+    void reserve(std::size_t capacity);
+
+    OrderPoolStats get_stats() const;
+
+private:
+    union Slot
+    {
+        Slot *next_free;
+        alignas(Order) unsigned char storage[sizeof(Order)];
+    };
+
+    void add_slab();
+
+    std::size_t slab_size_;
+    std::vector<std::unique_ptr<Slot[]>> slabs_;
+    Slot *free_list_ = nullptr;
+    std::size_t in_use_ = 0;
+    std::size_t high_water_mark_ = 0;
+};
+
+#endif // ORDER_POOL_HPP
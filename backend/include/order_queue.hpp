@@ -0,0 +1,91 @@
+#ifndef ORDER_QUEUE_HPP
+#define ORDER_QUEUE_HPP
+
+#include "order.hpp"
+#include <cstddef>
+#include <iterator>
+
+// Intrusive FIFO of the orders resting at one price level.
+//
+// The links live in the Order itself, so an order found through the id
+// lookup can be unlinked in O(1) regardless of how deep the level is.
+// The queue does not own its orders.
+class OrderQueue
+{
+public:
+    class const_iterator
+    {
+    public:
+        using value_type = Order *;
+        using reference = Order *;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        const_iterator() = default;
+        explicit const_iterator(Order *order) : order_(order) {}
+
+        Order *operator*() const { return order_; }
+        const_iterator &operator++()
+        {
+            order_ = order_->next_;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator previous = *this;
+            order_ = order_->next_;
+            return previous;
+        }
+        bool operator==(const const_iterator &other) const { return order_ == other.order_; }
+
+    private:
+        Order *order_ = nullptr;
+    };
+
+    bool empty() const { return head_ == nullptr; }
+    Order *front() const { return head_; }
+    const_iterator begin() const { return const_iterator(head_); }
+    const_iterator end() const { return const_iterator(); }
+
+    bool contains(const Order *order) const { return order->prev_ != nullptr || head_ == order; }
+
+    void push_back(Order *order)
+    {
+        order->prev_ = tail_;
+        order->next_ = nullptr;
+        if (tail_)
+            tail_->next_ = order;
+        else
+            head_ = order;
+        tail_ = order;
+    }
+
+    void pop_front() { erase(head_); }
+
+    // Unlinks an order queued at this level; orders that are not queued are ignored.
+    void erase(Order *order)
+    {
+        if (!contains(order))
+            return;
+
+        if (order->prev_)
+            order->prev_->next_ = order->next_;
+        else
+            head_ = order->next_;
+
+        if (order->next_)
+            order->next_->prev_ = order->prev_;
+        else
+            tail_ = order->prev_;
+
+        order->prev_ = nullptr;
+        order->next_ = nullptr;
+    }
+
+private:
+    Order *head_ = nullptr;
+    Order *tail_ = nullptr;
+};
+
+#endif // ORDER_QUEUE_HPP
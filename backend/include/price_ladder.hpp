@@ -0,0 +1,338 @@
+#ifndef PRICE_LADDER_HPP
+#define PRICE_LADDER_HPP
+
+#include "order.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Flat, tick-indexed alternative to std::map<Price, Level, Compare>.
+//
+// Levels live in a contiguous window of slots ordered best-first for the
+// given comparator, so slot 0 is the highest price for bids (std::greater)
+// and the lowest price for asks (std::less). An occupancy bitmap finds the
+// next non-empty level and the best occupied slot is tracked explicitly.
+// The window recenters (and grows if needed) when a price falls outside it,
+// but never beyond `max_level_count` slots: a price that would need a wider
+// window is rejected with std::invalid_argument, and callers check `fits`
+// before committing to a price.
+//
+// Only the subset of the std::map interface used by OrderBook and
+// MatchingEngine is provided.
+template <typename Level, typename Compare>
+class PriceLadder
+{
+    static_assert(std::is_same_v<Compare, std::less<Price>> ||
+                      std::is_same_v<Compare, std::greater<Price>>,
+                  "PriceLadder supports std::less<Price> or std::greater<Price> ordering");
+
+public:
+    using key_type = Price;
+    using mapped_type = Level;
+    using key_compare = Compare;
+    using value_type = std::pair<Price, Level>;
+    using size_type = std::size_t;
+
+    template <bool Const>
+    class basic_iterator
+    {
+    public:
+        using ladder_type = std::conditional_t<Const, const PriceLadder, PriceLadder>;
+        using value_type = PriceLadder::value_type;
+        using reference = std::conditional_t<Const, const value_type &, value_type &>;
+        using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        basic_iterator() = default;
+        basic_iterator(ladder_type *ladder, std::size_t index) : ladder_(ladder), index_(index) {}
+        operator basic_iterator<true>() const
+            requires(!Const)
+        {
+            return {ladder_, index_};
+        }
+
+        reference operator*() const { return ladder_->slots_[index_]; }
+        pointer operator->() const { return &ladder_->slots_[index_]; }
+
+        basic_iterator &operator++()
+        {
+            index_ = ladder_->next_occupied(index_ + 1);
+            return *this;
+        }
+
+        basic_iterator operator++(int)
+        {
+            basic_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const basic_iterator &other) const { return index_ == other.index_; }
+
+        std::size_t index() const { return index_; }
+
+    private:
+        ladder_type *ladder_ = nullptr;
+        std::size_t index_ = 0;
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    PriceLadder(Price center_price, Price tick_size, std::size_t level_count, std::size_t max_level_count);
+
+    bool empty() const { return size_ == 0; }
+    size_type size() const { return size_; }
+    Price tick_size() const { return tick_; }
+    std::size_t capacity() const { return slots_.size(); }
+    // Whether `price` could be inserted without the window outgrowing its
+    // maximum; throws like operator[] if it is not a multiple of the tick.
+    bool fits(Price price) const;
+
+    iterator begin() { return {this, best_}; }
+    iterator end() { return {this, slots_.size()}; }
+    const_iterator begin() const { return {this, best_}; }
+    const_iterator end() const { return {this, slots_.size()}; }
+
+    Level &operator[](Price price);
+    iterator find(Price price);
+    const_iterator find(Price price) const;
+    iterator erase(const_iterator pos);
+    size_type erase(Price price);
+
+private:
+    static constexpr bool descending = std::is_same_v<Compare, std::greater<Price>>;
+    static constexpr std::size_t word_bits = 64;
+
+    // Signed slot index of a price relative to the current window origin.
+    std::int64_t offset_of(Price price) const;
+    Price price_at(std::int64_t offset) const;
+    bool in_window(std::int64_t offset) const;
+
+    bool occupied(std::size_t index) const;
+    void set_occupied(std::size_t index);
+    void clear_occupied(std::size_t index);
+    std::size_t next_occupied(std::size_t from) const;
+    std::size_t last_occupied() const;
+
+    // Slots a window needs to hold the occupied levels and `offset`.
+    std::size_t span_with(std::int64_t offset) const;
+    // Moves the window so that the given offset is inside it.
+    std::size_t recenter(std::int64_t offset);
+
+    Price origin_;
+    Price tick_;
+    std::vector<value_type> slots_;
+    std::vector<std::uint64_t> occupancy_;
+    std::size_t best_;
+    std::size_t size_ = 0;
+    std::size_t max_levels_;
+};
+
+// === IMPLEMENTATION OF TEMPLATE FUNCTIONS ===
+
+template <typename Level, typename Compare>
+PriceLadder<Level, Compare>::PriceLadder(Price center_price, Price tick_size, std::size_t level_count,
+                                         std::size_t max_level_count)
+    : tick_(tick_size), max_levels_(max_level_count)
+{
+    if (tick_size <= 0)
+        throw std::invalid_argument("PriceLadder tick size must be positive");
+    if (level_count == 0)
+        throw std::invalid_argument("PriceLadder level count must be positive");
+    if (max_level_count < level_count)
+        throw std::invalid_argument("PriceLadder maximum level count must be at least its level count");
+
+    std::int64_t half = static_cast<std::int64_t>(level_count / 2) * tick_;
+    origin_ = static_cast<Price>(descending ? center_price + half : center_price - half);
+
+    slots_.resize(level_count);
+    for (std::size_t i = 0; i < level_count; ++i)
+        slots_[i].first = price_at(static_cast<std::int64_t>(i));
+    occupancy_.assign((level_count + word_bits - 1) / word_bits, 0);
+    best_ = slots_.size();
+}
+
+template <typename Level, typename Compare>
+Level &PriceLadder<Level, Compare>::operator[](Price price)
+{
+    std::int64_t offset = offset_of(price);
+    std::size_t index = in_window(offset) ? static_cast<std::size_t>(offset) : recenter(offset);
+    if (!occupied(index))
+    {
+        set_occupied(index);
+        ++size_;
+        if (index < best_)
+            best_ = index;
+    }
+    return slots_[index].second;
+}
+
+template <typename Level, typename Compare>
+typename PriceLadder<Level, Compare>::iterator PriceLadder<Level, Compare>::find(Price price)
+{
+    std::int64_t offset = offset_of(price);
+    if (!in_window(offset) || !occupied(static_cast<std::size_t>(offset)))
+        return end();
+    return {this, static_cast<std::size_t>(offset)};
+}
+
+template <typename Level, typename Compare>
+typename PriceLadder<Level, Compare>::const_iterator PriceLadder<Level, Compare>::find(Price price) const
+{
+    std::int64_t offset = offset_of(price);
+    if (!in_window(offset) || !occupied(static_cast<std::size_t>(offset)))
+        return end();
+    return {this, static_cast<std::size_t>(offset)};
+}
+
+template <typename Level, typename Compare>
+typename PriceLadder<Level, Compare>::iterator PriceLadder<Level, Compare>::erase(const_iterator pos)
+{
+    std::size_t index = pos.index();
+    slots_[index].second = Level{};
+    clear_occupied(index);
+    --size_;
+    std::size_t next = next_occupied(index + 1);
+    if (index == best_)
+        best_ = next;
+    return {this, next};
+}
+
+template <typename Level, typename Compare>
+typename PriceLadder<Level, Compare>::size_type PriceLadder<Level, Compare>::erase(Price price)
+{
+    auto it = find(price);
+    if (it == end())
+        return 0;
+    erase(it);
+    return 1;
+}
+
+template <typename Level, typename Compare>
+bool PriceLadder<Level, Compare>::fits(Price price) const
+{
+    std::int64_t offset = offset_of(price);
+    return in_window(offset) || span_with(offset) <= max_levels_;
+}
+
+template <typename Level, typename Compare>
+std::int64_t PriceLadder<Level, Compare>::offset_of(Price price) const
+{
+    std::int64_t distance = descending ? std::int64_t{origin_} - price : std::int64_t{price} - origin_;
+    if (distance % tick_ != 0)
+        throw std::runtime_error("Price is not a multiple of the tick size");
+    return distance / tick_;
+}
+
+template <typename Level, typename Compare>
+Price PriceLadder<Level, Compare>::price_at(std::int64_t offset) const
+{
+    std::int64_t distance = offset * tick_;
+    return static_cast<Price>(descending ? origin_ - distance : origin_ + distance);
+}
+
+template <typename Level, typename Compare>
+bool PriceLadder<Level, Compare>::in_window(std::int64_t offset) const
+{
+    return offset >= 0 && offset < static_cast<std::int64_t>(slots_.size());
+}
+
+template <typename Level, typename Compare>
+bool PriceLadder<Level, Compare>::occupied(std::size_t index) const
+{
+    return (occupancy_[index / word_bits] >> (index % word_bits)) & 1u;
+}
+
+template <typename Level, typename Compare>
+void PriceLadder<Level, Compare>::set_occupied(std::size_t index)
+{
+    occupancy_[index / word_bits] |= std::uint64_t{1} << (index % word_bits);
+}
+
+template <typename Level, typename Compare>
+void PriceLadder<Level, Compare>::clear_occupied(std::size_t index)
+{
+    occupancy_[index / word_bits] &= ~(std::uint64_t{1} << (index % word_bits));
+}
+
+template <typename Level, typename Compare>
+std::size_t PriceLadder<Level, Compare>::next_occupied(std::size_t from) const
+{
+    if (from >= slots_.size())
+        return slots_.size();
+
+    std::size_t word = from / word_bits;
+    std::uint64_t bits = occupancy_[word] & (~std::uint64_t{0} << (from % word_bits));
+    while (bits == 0)
+    {
+        if (++word == occupancy_.size())
+            return slots_.size();
+        bits = occupancy_[word];
+    }
+    return word * word_bits + static_cast<std::size_t>(std::countr_zero(bits));
+}
+
+template <typename Level, typename Compare>
+std::size_t PriceLadder<Level, Compare>::last_occupied() const
+{
+    for (std::size_t word = occupancy_.size(); word-- > 0;)
+    {
+        if (occupancy_[word] != 0)
+            return word * word_bits + (word_bits - 1 - static_cast<std::size_t>(std::countl_zero(occupancy_[word])));
+    }
+    return slots_.size();
+}
+
+template <typename Level, typename Compare>
+std::size_t PriceLadder<Level, Compare>::span_with(std::int64_t offset) const
+{
+    if (empty())
+        return 1;
+    std::int64_t low = std::min<std::int64_t>(offset, static_cast<std::int64_t>(best_));
+    std::int64_t high = std::max<std::int64_t>(offset, static_cast<std::int64_t>(last_occupied()));
+    return static_cast<std::size_t>(high - low + 1);
+}
+
+template <typename Level, typename Compare>
+std::size_t PriceLadder<Level, Compare>::recenter(std::int64_t offset)
+{
+    std::size_t span = span_with(offset);
+    if (span > max_levels_)
+        throw std::invalid_argument("Price is too far from the other levels for the price ladder");
+    std::int64_t low = empty() ? offset : std::min<std::int64_t>(offset, static_cast<std::int64_t>(best_));
+
+    std::size_t capacity = slots_.size();
+    while (capacity < span)
+        capacity = std::min(capacity * 2, max_levels_);
+
+    // Old offset that becomes slot 0 of the new window, leaving equal room on both sides.
+    std::int64_t shift = low - static_cast<std::int64_t>((capacity - span) / 2);
+
+    std::vector<value_type> slots(capacity);
+    std::vector<std::uint64_t> occupancy((capacity + word_bits - 1) / word_bits, 0);
+    for (std::size_t index = best_; index < slots_.size(); index = next_occupied(index + 1))
+    {
+        std::size_t moved = static_cast<std::size_t>(static_cast<std::int64_t>(index) - shift);
+        slots[moved].second = std::move(slots_[index].second);
+        occupancy[moved / word_bits] |= std::uint64_t{1} << (moved % word_bits);
+    }
+
+    origin_ = price_at(shift);
+    slots_ = std::move(slots);
+    occupancy_ = std::move(occupancy);
+    for (std::size_t i = 0; i < slots_.size(); ++i)
+        slots_[i].first = price_at(static_cast<std::int64_t>(i));
+    best_ = empty() ? slots_.size() : static_cast<std::size_t>(static_cast<std::int64_t>(best_) - shift);
+
+    return static_cast<std::size_t>(offset - shift);
+}
+
+#endif // PRICE_LADDER_HPP
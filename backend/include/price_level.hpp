@@ -0,0 +1,78 @@
+#ifndef PRICE_LEVEL_HPP
+#define PRICE_LEVEL_HPP
+
+#include "order.hpp"
+#include "order_queue.hpp"
+#include <cstdint>
+#include <vector>
+
+// Aggregated view of one price level as reported by depth queries.
+struct OrderLevel {
+    Price price;
+    Quantity quantity;
+    std::uint32_t order_count;
+};
+
+using OrderLevels = std::vector<OrderLevel>;
+
+// Orders resting at one price together with their running aggregates.
+//
+// total_quantity and order_count are maintained on every add, fill, cancel
+// and modify, so depth queries never have to walk the queue. Icebergs count
+// only their visible slice in total_quantity; their reserves are summed in
+// hidden_quantity, and iceberg_count lets matching skip the refill handling
+// on levels without any.
+struct PriceLevel
+{
+    OrderQueue orders;
+    Quantity total_quantity = 0;
+    Quantity hidden_quantity = 0;
+    std::uint32_t order_count = 0;
+    std::uint32_t iceberg_count = 0;
+
+    bool empty() const { return orders.empty(); }
+    OrderPointer front() const { return orders.front(); }
+
+    void push_back(OrderPointer order)
+    {
+        orders.push_back(order);
+        ++order_count;
+        if (order->is_iceberg())
+        {
+            total_quantity += order->get_visible_quantity();
+            hidden_quantity += order->get_hidden_quantity();
+            ++iceberg_count;
+        }
+        else
+        {
+            total_quantity += order->get_remaining_quantity();
+        }
+    }
+
+    void pop_front() { erase(orders.front()); }
+
+    // Removes an order queued at this level; orders that are not queued are ignored.
+    void erase(OrderPointer order)
+    {
+        if (!orders.contains(order))
+            return;
+        orders.erase(order);
+        --order_count;
+        if (order->is_iceberg())
+        {
+            total_quantity -= order->get_visible_quantity();
+            hidden_quantity -= order->get_hidden_quantity();
+            --iceberg_count;
+        }
+        else
+        {
+            total_quantity -= order->get_remaining_quantity();
+        }
+    }
+
+    // Accounts for a fill of `quantity` against the visible quantity of an
+    // order queued at this level.
+    void reduce(Quantity quantity) { total_quantity -= quantity; }
+};
+
+#endif // PRICE_LEVEL_HPP
@@ -0,0 +1,258 @@
+#ifndef SHARD_HPP
+#define SHARD_HPP
+
+#include "journal.hpp"
+#include "order.hpp"
+#include "order_book.hpp"
+#include "logger.hpp"
+#include "market_analytics.hpp"
+#include "spsc_queue.hpp"
+#include "stage_stats.hpp"
+#include "symbol.hpp"
+#include "trade_store.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class ShardCommand : std::uint8_t
+{
+    add,
+    cancel,
+    modify,
+    summary,
+    subscribe,   // start publishing market data; answered with a snapshot
+    unsubscribe, // stop publishing market data
+    market_data, // response only: level deltas and trades from one pass
+    stats,       // copy of the shard's counters and stage histograms
+    analytics,   // the book's quote and trade analytics
+    trades,      // timestamped trades in a time range
+    bars         // OHLCV bars of one resolution in a time range
+};
+
+// Counters and stage histograms kept by one shard; a stats request answers
+// with a copy.
+struct ShardStats
+{
+    std::uint64_t orders = 0;   // accepted adds
+    std::uint64_t cancels = 0;
+    std::uint64_t modifies = 0;
+    std::uint64_t trades = 0;
+    std::uint64_t rejects = 0;  // requests answered with an error
+    std::size_t books = 0;
+    std::size_t request_queue_depth = 0;
+    std::size_t response_queue_depth = 0;
+    StageStats stages;          // queue, match and commit
+};
+
+struct ShardRequest
+{
+    std::uint64_t token = 0; // opaque to the shard, echoed in the response
+    ShardCommand command = ShardCommand::add;
+    Symbol symbol;
+    OrderID id = 0;
+    OrderType type = OrderType::good_till_cancel;
+    OrderSide side = OrderSide::buy;
+    Price price = 0;
+    Quantity quantity = 0;
+    Price stop_price = 0;         // add: stop and stop_limit orders
+    Quantity display_quantity = 0; // add: icebergs
+    std::size_t depth = 0; // summary: levels per side
+    std::uint64_t known_version = 0; // summary: book version the requester already holds, 0 if none
+    std::uint64_t from_ns = 0;       // trades, bars: inclusive range, nanoseconds since the epoch
+    std::uint64_t to_ns = 0;
+    std::uint32_t limit = 0;         // trades, bars: most recent entries returned at most
+    BarResolution resolution = BarResolution::one_second; // bars
+    std::uint64_t received_at = 0;   // stats_stamp when the frame was read, echoed in the response
+    std::uint64_t submitted_at = 0;  // stats_stamp when queued for the shard
+};
+
+struct ShardResponse
+{
+    std::uint64_t token = 0;
+    ShardCommand command = ShardCommand::add;
+    Symbol symbol;
+    OrderID id = 0;
+    bool ok = true;
+    OrderStatus status = OrderStatus::open; // add: final status of the incoming order
+    Quantity filled = 0;                    // add: quantity executed on arrival
+    std::uint32_t trade_count = 0;          // add: trades the incoming order took part in on arrival
+    std::string error;                      // set when !ok
+    OrderLevels bids;                       // summary, snapshot, or changed levels
+    OrderLevels asks;                       // summary, snapshot, or changed levels
+    std::uint64_t sequence = 0;             // market_data: update number; subscribe: last update before the snapshot
+    std::vector<Trade> trades;              // market_data
+    std::uint64_t version = 0;              // summary: book version the levels reflect
+    bool unchanged = false;                 // summary: version == known_version, levels omitted
+    std::shared_ptr<const ShardStats> stats; // stats
+    std::shared_ptr<const AnalyticsSnapshot> analytics; // analytics
+    std::vector<TimedTrade> trade_history;  // trades
+    std::vector<Bar> bars;                  // bars
+    BarResolution resolution = BarResolution::one_second; // bars
+    std::uint64_t received_at = 0;          // from the request
+    std::uint64_t handled_at = 0;           // stats_stamp when the shard finished the request
+    std::uint64_t published_at = 0;         // stats_stamp when pushed onto the response queue
+};
+
+// Partitions order books across worker threads by symbol.
+//
+// Each shard thread exclusively owns the books hashed to it, so books need
+// no locks. One front-end thread submits requests through a per-shard SPSC
+// queue and collects responses from a per-shard SPSC queue; `notify` is
+// called from a shard thread whenever it has published responses, and
+// should wake the front-end thread to call poll_responses.
+//
+// Books with subscribers publish one market_data response per shard pass in
+// which they changed, carrying the new aggregate of every changed level and
+// the trades since the previous update. Updates are numbered per symbol and
+// share the response queue, so a subscribe snapshot is ordered before every
+// update that follows it.
+//
+// Every book also keeps a MarketAnalytics and a TradeStore, fed at the end
+// of each pass with the same level changes and trades that market data
+// publishes; trades are stamped with the wall clock as they are collected.
+// Analytics, trades and bars requests first collect the book's changes so
+// far, then are answered from those without looking at the book.
+//
+// With a journal directory configured, each shard appends every accepted
+// add, cancel and modify to its own journal (`<directory>/shard-N`) and
+// commits once per pass before any response of that pass is published.
+// Every `snapshot_interval` records, and on shutdown, it also writes a
+// snapshot of its resting orders and drops the journal segments the
+// snapshot covers. On start each shard restores its snapshot and replays
+// the journal tail after it; the constructor returns once every shard has
+// recovered, and rethrows if one could not. Symbols map to shards by
+// count, so a journal can only be reopened with the shard count it was
+// written with.
+//
+// Each shard counts what it handles and times the stages it owns; a stats
+// request, sent to each shard with submit_to, answers with a copy.
+class ShardPool
+{
+public:
+    ShardPool(std::size_t shard_count, std::function<void()> notify,
+              LogLevel log_level = LogLevel::info, const JournalConfig &journal = {},
+              const AnalyticsConfig &analytics = {}, const TradeStoreConfig &trade_store = {},
+              std::size_t queue_capacity = 65536);
+    ~ShardPool();
+
+    ShardPool(const ShardPool &) = delete;
+    ShardPool &operator=(const ShardPool &) = delete;
+
+    std::size_t size() const { return shards_.size(); }
+    std::size_t shard_for(const Symbol &symbol) const;
+
+    // Front-end thread only. Returns false if the owning shard's queue is full.
+    bool submit(const ShardRequest &request);
+    // As submit, to a given shard rather than the symbol's.
+    bool submit_to(std::size_t shard, const ShardRequest &request);
+
+    // Front-end thread only. Hands every available response to `handler`.
+    template <typename Handler>
+    std::size_t poll_responses(Handler &&handler);
+
+private:
+    class Shard
+    {
+    public:
+        Shard(std::size_t queue_capacity, LogLevel log_level, const std::function<void()> &notify,
+              const JournalConfig *journal, const AnalyticsConfig &analytics,
+              const TradeStoreConfig &trade_store);
+        ~Shard();
+
+        SpscQueue<ShardRequest> requests;
+        SpscQueue<ShardResponse> responses;
+
+        // Blocks until the shard has recovered its books; rethrows a recovery failure.
+        void wait_ready() { ready_.get_future().get(); }
+
+    private:
+        struct BookEntry
+        {
+            Symbol symbol;
+            std::unique_ptr<OrderBook> book;
+            MarketAnalytics analytics;
+            TradeStore trade_store;
+            bool subscribed = false;
+            bool touched = false;              // changed in the current pass
+            std::uint64_t update_sequence = 0; // last published update
+            TradeSequence trade_cursor = 0;    // next trade to collect
+        };
+
+        // Responses held back per pass until the journal has committed it.
+        static constexpr std::size_t max_pass_size = 1024;
+
+        void run();
+        void recover();
+        void take_snapshot();
+        void handle(const ShardRequest &request, ShardResponse &response);
+        // Journals an applied command; a journal failure fails the pass and refuses later changes.
+        void record(const ShardRequest &request);
+        void fail_journal(const std::string &error);
+        // Replaces the acknowledgements of a failed pass with the journal error.
+        void hold_unjournaled();
+        void publish(ShardResponse &&response);
+        // Takes the level changes and trades since the last call into a
+        // market_data update and feeds them to the book's analytics and trade
+        // store; false if nothing changed.
+        bool collect(BookEntry &entry, ShardResponse &update);
+        // Collects a book's changes and, if it has subscribers, queues them
+        // as an update to follow the pass's replies.
+        void flush(BookEntry &entry);
+        // Starts level tracking and seeds the analytics from the book as it stands.
+        void track(BookEntry &entry);
+        void touch(BookEntry &entry);
+        BookEntry &book_for(const Symbol &symbol);
+
+        const std::function<void()> &notify_;
+        LogLevel log_level_;
+        AsyncLogger logger_;
+        AnalyticsConfig analytics_config_;
+        TradeStoreConfig trade_store_config_;
+        std::unordered_map<Symbol, BookEntry, SymbolHash> books_;
+        std::vector<BookEntry *> touched_;    // books changed in the current pass
+        std::vector<ShardResponse> updates_;  // market data and subscribe snapshots of the current pass, in order
+        bool tracking_ = false;               // off while recovering
+        std::unique_ptr<Journal> journal_; // null when journaling is off
+        std::string journal_error_;        // set once an append or commit fails; books are read-only from then on
+        std::uint64_t snapshot_interval_ = 0;
+        std::uint64_t snapshot_sequence_ = 0; // journal record the last snapshot was taken (or attempted) at
+        std::vector<ShardResponse> staged_;
+        ShardStats stats_;
+        std::promise<void> ready_;
+        std::atomic<bool> running_{true};
+        std::thread thread_;
+    };
+
+    // Records the shard count in the journal directory, or checks it against the recorded one.
+    static void check_journal_layout(const std::string &directory, std::size_t shard_count);
+
+    std::function<void()> notify_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+// === IMPLEMENTATION OF TEMPLATE FUNCTIONS ===
+
+template <typename Handler>
+std::size_t ShardPool::poll_responses(Handler &&handler)
+{
+    std::size_t count = 0;
+    ShardResponse response;
+    for (auto &shard : shards_)
+    {
+        while (shard->responses.try_pop(response))
+        {
+            handler(std::move(response));
+            ++count;
+        }
+    }
+    return count;
+}
+
+#endif // SHARD_HPP
@@ -0,0 +1,41 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include "order_book.hpp"
+#include "symbol.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Resting orders of one book, as listed by OrderBook::get_resting_orders.
+struct BookSnapshot
+{
+    Symbol symbol;
+    std::vector<RestingOrder> orders;
+};
+
+// Binary image of a shard's books as of one journal sequence.
+//
+// Layout, all integers little-endian:
+//   header  32 bytes  magic "OBSNAP02" | sequence u64 | book_count u32 | pad u32 | checksum u64
+//   book    24 bytes  symbol[16] | order_count u64, followed by its orders
+//   order   40 bytes  id u64 | price i32 | initial u32 | remaining u32 | type u8 | side u8 | pad[2]
+//                     | stop_price i32 | display u32 | visible u32 | pad u32
+//
+// The checksum is FNV-1a over everything after the header. Orders are in
+// price-time order, followed by the pending stops, and carry their ids, so
+// restoring rebuilds the levels, the stops and the id index in one pass
+// without matching.
+
+// Name of the snapshot file a shard keeps beside its journal segments.
+inline constexpr char snapshot_file_name[] = "snapshot.bin";
+
+// Writes a temporary file, syncs it and renames it over `path`, so a crash
+// leaves either the previous snapshot or the new one.
+void write_snapshot(const std::string &path, std::uint64_t sequence, const std::vector<BookSnapshot> &books);
+
+// Maps and decodes the snapshot at `path`. Returns false if there is none;
+// throws std::runtime_error if it is truncated or corrupt.
+bool read_snapshot(const std::string &path, std::uint64_t &sequence, std::vector<BookSnapshot> &books);
+
+#endif // SNAPSHOT_HPP
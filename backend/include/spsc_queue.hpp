@@ -0,0 +1,99 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Capacity is rounded up to a power of two. Each side caches the
+// other side's index so the shared atomics are only re-read when the queue
+// looks full (producer) or empty (consumer).
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(std::size_t capacity);
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer side. Returns false if the queue is full.
+    template <typename U>
+    bool try_push(U &&value);
+
+    // Consumer side. Returns false if the queue is empty.
+    bool try_pop(T &value);
+
+    std::size_t capacity() const { return buffer_.size(); }
+    // Approximate when called concurrently with either side.
+    std::size_t size() const;
+    bool empty() const { return size() == 0; }
+
+private:
+    static constexpr std::size_t cache_line = 64;
+
+    std::vector<T> buffer_;
+    std::size_t mask_;
+
+    alignas(cache_line) std::atomic<std::size_t> head_{0}; // next slot to pop
+    std::size_t cached_tail_ = 0;                          // consumer's view of tail_
+
+    alignas(cache_line) std::atomic<std::size_t> tail_{0}; // next slot to push
+    std::size_t cached_head_ = 0;                          // producer's view of head_
+};
+
+// === IMPLEMENTATION OF TEMPLATE FUNCTIONS ===
+
+template <typename T>
+SpscQueue<T>::SpscQueue(std::size_t capacity)
+{
+    if (capacity == 0)
+        throw std::invalid_argument("SpscQueue capacity must be positive");
+    buffer_.resize(std::bit_ceil(capacity));
+    mask_ = buffer_.size() - 1;
+}
+
+template <typename T>
+template <typename U>
+bool SpscQueue<T>::try_push(U &&value)
+{
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == buffer_.size())
+    {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail - cached_head_ == buffer_.size())
+            return false;
+    }
+    buffer_[tail & mask_] = std::forward<U>(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::try_pop(T &value)
+{
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_)
+    {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head == cached_tail_)
+            return false;
+    }
+    value = std::move(buffer_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+std::size_t SpscQueue<T>::size() const
+{
+    std::size_t tail = tail_.load(std::memory_order_acquire);
+    std::size_t head = head_.load(std::memory_order_acquire);
+    return tail - head;
+}
+
+#endif // SPSC_QUEUE_HPP
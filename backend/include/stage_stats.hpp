@@ -0,0 +1,85 @@
+#ifndef STAGE_STATS_HPP
+#define STAGE_STATS_HPP
+
+#include "latency_histogram.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Per-stage latency instrumentation is compiled out entirely with
+// -DORDERBOOK_STATS=0: stamps read as 0 and recording does nothing.
+#ifndef ORDERBOOK_STATS
+#define ORDERBOOK_STATS 1
+#endif
+
+inline constexpr bool stats_compiled = ORDERBOOK_STATS != 0;
+
+// The stages a request passes through, in order. Front-end stages are
+// recorded on the io_context thread, the others on the owning shard's thread.
+enum class Stage : std::uint8_t
+{
+    parse,     // front end: frame read until its requests are decoded
+    queue,     // submitted until the shard pops it
+    match,     // shard: the add/cancel/modify call on the book
+    commit,    // shard: handled until published, including the journal commit
+    dispatch,  // published until the front end picks the response up
+    serialize, // front end: encoding the reply
+    write,     // front end: reply queued until async_write completes
+    total      // frame read until its reply is written
+};
+
+inline constexpr std::size_t stage_count = static_cast<std::size_t>(Stage::total) + 1;
+
+const char *stage_name(Stage stage);
+
+// Current value of the CPU's cycle counter (the TSC on x86, the virtual
+// counter on ARM64, steady_clock nanoseconds elsewhere), or 0 when stats are
+// compiled out. Stamps taken on different cores are comparable only on
+// machines with a synchronized, invariant counter, as current x86 and ARM64
+// servers have.
+inline std::uint64_t stats_stamp()
+{
+    if constexpr (!stats_compiled)
+        return 0;
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    std::uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Nanoseconds per stats_stamp tick, measured against steady_clock on first
+// use (which blocks for a few milliseconds); call it at startup.
+double stats_nanoseconds_per_tick();
+
+// One histogram of tick counts per stage, owned by a single thread.
+class StageStats
+{
+public:
+    void record(Stage stage, std::uint64_t start, std::uint64_t end)
+    {
+        if constexpr (stats_compiled)
+        {
+            // A stamp of 0 marks a request that was never stamped (e.g. an internal one).
+            if (start != 0 && end >= start)
+                histograms_[static_cast<std::size_t>(stage)].record(end - start);
+        }
+    }
+
+    void merge(const StageStats &other);
+    const LatencyHistogram &histogram(Stage stage) const { return histograms_[static_cast<std::size_t>(stage)]; }
+
+private:
+    std::array<LatencyHistogram, stats_compiled ? stage_count : 0> histograms_;
+};
+
+#endif // STAGE_STATS_HPP
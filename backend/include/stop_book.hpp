@@ -0,0 +1,110 @@
+#ifndef STOP_BOOK_HPP
+#define STOP_BOOK_HPP
+
+#include "order.hpp"
+#include "order_queue.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <map>
+
+// Pending stop orders of one book, indexed by stop price.
+//
+// A buy stop triggers once a trade prints at or above its stop price and a
+// sell stop once one prints at or below it, so buys are kept ascending and
+// sells descending: the next stop to trigger on either side is always at the
+// front. Trades only widen the range of prices printed since the last check,
+// and a check compares that range with the two fronts, so its cost grows
+// with the stops it triggers rather than with the stops pending. Stops at
+// one price trigger in arrival order, queued through the same intrusive
+// links as resting orders.
+class StopBook
+{
+public:
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+
+    void push_back(OrderPointer order)
+    {
+        if (order->get_side() == OrderSide::buy)
+            buys_[order->get_stop_price()].push_back(order);
+        else
+            sells_[order->get_stop_price()].push_back(order);
+        ++size_;
+    }
+
+    void erase(OrderPointer order)
+    {
+        if (order->get_side() == OrderSide::buy)
+            erase_from(buys_, order);
+        else
+            erase_from(sells_, order);
+    }
+
+    // Widens the range the next check compares stops against.
+    void on_trade(Price price)
+    {
+        low_ = std::min(low_, price);
+        high_ = std::max(high_, price);
+    }
+
+    // Removes and returns the next stop the traded range reaches, buys
+    // before sells. Once none is left it returns nullptr and the range
+    // starts over, so trades made by the stops it returned count as well.
+    OrderPointer pop_triggered()
+    {
+        if (!buys_.empty() && buys_.begin()->first <= high_)
+            return pop_front(buys_);
+        if (!sells_.empty() && sells_.begin()->first >= low_)
+            return pop_front(sells_);
+        low_ = std::numeric_limits<Price>::max();
+        high_ = std::numeric_limits<Price>::min();
+        return nullptr;
+    }
+
+    // Calls `visitor` with every pending stop in trigger order, buys first.
+    template <typename Visitor>
+    void for_each(Visitor &&visitor) const
+    {
+        for (const auto &[price, queue] : buys_)
+            for (const Order *order : queue)
+                visitor(order);
+        for (const auto &[price, queue] : sells_)
+            for (const Order *order : queue)
+                visitor(order);
+    }
+
+private:
+    template <typename Levels>
+    OrderPointer pop_front(Levels &levels)
+    {
+        auto it = levels.begin();
+        OrderPointer order = it->second.front();
+        it->second.pop_front();
+        if (it->second.empty())
+            levels.erase(it);
+        --size_;
+        return order;
+    }
+
+    template <typename Levels>
+    void erase_from(Levels &levels, OrderPointer order)
+    {
+        auto it = levels.find(order->get_stop_price());
+        if (it == levels.end() || !it->second.contains(order))
+            return;
+        it->second.erase(order);
+        if (it->second.empty())
+            levels.erase(it);
+        --size_;
+    }
+
+    std::map<Price, OrderQueue, std::less<Price>> buys_;
+    std::map<Price, OrderQueue, std::greater<Price>> sells_;
+    std::size_t size_ = 0;
+    Price low_ = std::numeric_limits<Price>::max();
+    Price high_ = std::numeric_limits<Price>::min();
+};
+
+#endif // STOP_BOOK_HPP
@@ -0,0 +1,42 @@
+#ifndef SYMBOL_HPP
+#define SYMBOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+
+// Instrument name stored inline so requests can cross threads without allocating.
+class Symbol
+{
+public:
+    static constexpr std::size_t max_length = 15;
+
+    Symbol() = default;
+    explicit Symbol(std::string_view name)
+    {
+        if (name.empty() || name.size() > max_length)
+            throw std::invalid_argument("Symbol must be 1-15 characters");
+        name.copy(chars_.data(), name.size());
+        length_ = static_cast<std::uint8_t>(name.size());
+    }
+
+    std::string_view view() const { return {chars_.data(), length_}; }
+    bool operator==(const Symbol &other) const { return view() == other.view(); }
+
+private:
+    std::array<char, max_length> chars_{};
+    std::uint8_t length_ = 0;
+};
+
+struct SymbolHash
+{
+    std::size_t operator()(const Symbol &symbol) const { return std::hash<std::string_view>{}(symbol.view()); }
+};
+
+// Book used when a request does not name an instrument.
+inline const Symbol default_symbol{"DEFAULT"};
+
+#endif // SYMBOL_HPP
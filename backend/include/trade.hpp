@@ -2,7 +2,6 @@
 #define TRADE_HPP
 
 #include "order.hpp"
-#include <vector>
 
 struct TradeInfo
 {
@@ -11,18 +10,27 @@ struct TradeInfo
     Quantity quantity;
 };
 
+// One execution between a bid and an ask order. Both sides trade the same
+// price and quantity, so they are stored once.
 class Trade
 {
 public:
-    Trade(const TradeInfo &bid_trade, const TradeInfo &ask_trade);
-    const TradeInfo &get_bid_trade() const;
-    const TradeInfo &get_ask_trade() const;
+    Trade() = default;
+    Trade(OrderID bid_order_id, OrderID ask_order_id, Price price, Quantity quantity);
+
+    OrderID get_bid_order_id() const;
+    OrderID get_ask_order_id() const;
+    Price get_price() const;
+    Quantity get_quantity() const;
+
+    TradeInfo get_bid_trade() const;
+    TradeInfo get_ask_trade() const;
 
 private:
-    TradeInfo bid_trade_;
-    TradeInfo ask_trade_;
+    OrderID bid_order_id_ = 0;
+    OrderID ask_order_id_ = 0;
+    Price price_ = 0;
+    Quantity quantity_ = 0;
 };
 
-using Trades = std::vector<Trade>;
-
 #endif // TRADE_HPP
@@ -0,0 +1,110 @@
+#ifndef TRADE_STORE_HPP
+#define TRADE_STORE_HPP
+
+#include "order.hpp"
+#include "trade.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct TimedTrade
+{
+    std::uint64_t time_ns = 0;
+    Trade trade;
+};
+
+enum class BarResolution : std::uint8_t
+{
+    one_second,
+    one_minute,
+    five_minutes
+};
+
+inline constexpr std::size_t bar_resolution_count = 3;
+
+// Width of a bar of the given resolution, in nanoseconds.
+std::uint64_t bar_width_ns(BarResolution resolution);
+const char *bar_resolution_name(BarResolution resolution);
+
+// One OHLCV bar; bars start on multiples of their width and only exist for
+// periods that traded.
+struct Bar
+{
+    std::uint64_t start_ns = 0;
+    Price open = 0;
+    Price high = 0;
+    Price low = 0;
+    Price close = 0;
+    std::uint64_t volume = 0;
+    std::uint32_t trades = 0;
+};
+
+struct TradeStoreConfig
+{
+    std::size_t block_trades = 4096;                // trades per block at most
+    std::size_t max_trades = 1 << 20;               // oldest blocks are dropped while the rest hold this many
+    std::uint64_t partition_ns = 60'000'000'000;    // a block never spans two partitions
+    std::size_t max_bars = 4096;                    // per resolution
+};
+
+// Timestamped trade history of one book.
+//
+// Trades are appended into blocks stored column by column (times, prices,
+// quantities, order ids), each block holding one time partition at most, so
+// a time search touches only the time column of one block after a binary
+// search over the blocks. Each block reserves room for `block_trades` up
+// front, so appends never reallocate a column; a block closed before it
+// filled (its partition ended) gives back the room it did not use.
+//
+// The oldest block is dropped whenever the others still hold `max_trades`,
+// so the store keeps at least the latest `max_trades` trades and at most one
+// block more, however the trades are spread over time. The last dropped
+// block is kept as a spare for the next block to start in.
+//
+// 1 s, 1 min and 5 min OHLCV bars are updated on every append, each
+// resolution keeping its latest `max_bars`.
+//
+// Times must not go backwards; an earlier time is recorded as the latest one
+// seen, which keeps every column sorted.
+class TradeStore
+{
+public:
+    explicit TradeStore(const TradeStoreConfig &config = {});
+
+    void append(const Trade &trade, std::uint64_t time_ns);
+
+    std::size_t size() const { return size_; }
+
+    // The most recent `limit` trades with from_ns <= time <= to_ns, oldest first.
+    std::vector<TimedTrade> trades(std::uint64_t from_ns, std::uint64_t to_ns, std::size_t limit) const;
+    // The most recent `limit` bars starting within [from_ns, to_ns], oldest first.
+    std::vector<Bar> bars(BarResolution resolution, std::uint64_t from_ns, std::uint64_t to_ns,
+                          std::size_t limit) const;
+
+private:
+    struct Block
+    {
+        std::uint64_t partition = 0;
+        std::vector<std::uint64_t> times;
+        std::vector<Price> prices;
+        std::vector<Quantity> quantities;
+        std::vector<OrderID> bid_order_ids;
+        std::vector<OrderID> ask_order_ids;
+
+        std::size_t size() const { return times.size(); }
+    };
+
+    Block &block_for(std::uint64_t time_ns);
+    void evict();
+
+    TradeStoreConfig config_;
+    std::deque<Block> blocks_;
+    Block spare_;
+    std::size_t size_ = 0;
+    std::uint64_t last_time_ = 0;
+    std::array<std::deque<Bar>, bar_resolution_count> bars_;
+};
+
+#endif // TRADE_STORE_HPP
@@ -0,0 +1,104 @@
+#ifndef TRADE_TAPE_HPP
+#define TRADE_TAPE_HPP
+
+#include "trade.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+using TradeSequence = std::uint64_t;
+
+// Fixed-capacity ring of the most recent trades.
+//
+// The book publishes every execution here; once the ring is full the oldest
+// trade is overwritten, so memory use is bounded no matter how long the
+// process runs. Each trade gets a sequence number and consumers (network
+// layer, journal, analytics) keep their own cursor and drain what is new
+// since their last call.
+class TradeTape
+{
+public:
+    class const_iterator
+    {
+    public:
+        using value_type = Trade;
+        using reference = const Trade &;
+        using pointer = const Trade *;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        const_iterator() = default;
+        const_iterator(const TradeTape *tape, TradeSequence sequence) : tape_(tape), sequence_(sequence) {}
+
+        reference operator*() const { return tape_->at(sequence_); }
+        pointer operator->() const { return &tape_->at(sequence_); }
+        const_iterator &operator++()
+        {
+            ++sequence_;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator previous = *this;
+            ++sequence_;
+            return previous;
+        }
+        bool operator==(const const_iterator &other) const { return sequence_ == other.sequence_; }
+
+    private:
+        const TradeTape *tape_ = nullptr;
+        TradeSequence sequence_ = 0;
+    };
+
+    // Capacity is rounded up to a power of two.
+    explicit TradeTape(std::size_t capacity);
+
+    void publish(const Trade &trade);
+
+    std::size_t capacity() const { return trades_.size(); }
+    std::size_t size() const { return static_cast<std::size_t>(next_sequence_ - first_sequence()); }
+    bool empty() const { return size() == 0; }
+
+    // Sequence the next published trade will get (also the number published so far).
+    TradeSequence next_sequence() const { return next_sequence_; }
+    // Oldest sequence still held in the ring.
+    TradeSequence first_sequence() const;
+
+    // Precondition: first_sequence() <= sequence < next_sequence().
+    const Trade &at(TradeSequence sequence) const { return trades_[sequence & mask_]; }
+
+    // Retained trades, oldest first.
+    const_iterator begin() const { return {this, first_sequence()}; }
+    const_iterator end() const { return {this, next_sequence_}; }
+
+    // Passes every trade from `cursor` onwards to `consumer` and advances the
+    // cursor past them. Returns how many trades the consumer missed because
+    // they were overwritten before it caught up.
+    template <typename Consumer>
+    std::uint64_t drain(TradeSequence &cursor, Consumer &&consumer) const;
+
+private:
+    std::vector<Trade> trades_;
+    std::uint64_t mask_;
+    TradeSequence next_sequence_ = 0;
+};
+
+// === IMPLEMENTATION OF TEMPLATE FUNCTIONS ===
+
+template <typename Consumer>
+std::uint64_t TradeTape::drain(TradeSequence &cursor, Consumer &&consumer) const
+{
+    std::uint64_t missed = 0;
+    TradeSequence first = first_sequence();
+    if (cursor < first)
+    {
+        missed = first - cursor;
+        cursor = first;
+    }
+    for (; cursor < next_sequence_; ++cursor)
+        consumer(at(cursor));
+    return missed;
+}
+
+#endif // TRADE_TAPE_HPP
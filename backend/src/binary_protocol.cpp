@@ -0,0 +1,415 @@
+#include "binary_protocol.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    void require_size(std::size_t size, std::size_t expected)
+    {
+        if (size < expected)
+            throw std::runtime_error("Truncated binary message");
+    }
+
+    Symbol read_symbol(const unsigned char *data)
+    {
+        const char *chars = reinterpret_cast<const char *>(data);
+        std::size_t length = 0;
+        while (length < binary_symbol_size && chars[length] != '\0')
+            ++length;
+        if (length > Symbol::max_length)
+            throw std::runtime_error("Symbol must be 1-15 characters");
+        return length == 0 ? default_symbol : Symbol(std::string_view(chars, length));
+    }
+
+    void write_symbol(unsigned char *data, const Symbol &symbol)
+    {
+        std::string_view name = symbol.view();
+        std::memcpy(data, name.data(), name.size());
+    }
+
+    OrderType read_order_type(std::uint8_t value)
+    {
+        if (value > static_cast<std::uint8_t>(OrderType::iceberg))
+            throw std::runtime_error("Unknown order type");
+        return static_cast<OrderType>(value);
+    }
+
+    OrderSide read_side(std::uint8_t value)
+    {
+        if (value > static_cast<std::uint8_t>(OrderSide::sell))
+            throw std::runtime_error("Unknown order side");
+        return static_cast<OrderSide>(value);
+    }
+
+    // Grows `out` by a zeroed, fixed-size message and returns its first byte.
+    unsigned char *append(std::string &out, std::size_t size)
+    {
+        std::size_t offset = out.size();
+        out.resize(offset + size, '\0');
+        return reinterpret_cast<unsigned char *>(out.data() + offset);
+    }
+
+    void read_levels(const unsigned char *data, std::uint32_t count, OrderLevels &levels)
+    {
+        levels.reserve(count);
+        for (std::uint32_t i = 0; i < count; ++i, data += binary_level_size)
+            levels.push_back({load_le<Price>(data), load_le<Quantity>(data + 4), load_le<std::uint32_t>(data + 8)});
+    }
+
+    unsigned char *write_levels(unsigned char *data, const OrderLevels &levels)
+    {
+        for (const auto &level : levels)
+        {
+            store_le(data, level.price);
+            store_le(data + 4, level.quantity);
+            store_le(data + 8, level.order_count);
+            data += binary_level_size;
+        }
+        return data;
+    }
+
+    // Size of one complete response starting at `data`.
+    std::size_t response_size(const unsigned char *data, std::size_t size)
+    {
+        require_size(size, 1);
+        switch (static_cast<BinaryMessage>(data[0]))
+        {
+        case BinaryMessage::execution_report:
+            return binary_execution_report_size;
+        case BinaryMessage::reject:
+            require_size(size, binary_reject_header_size);
+            return binary_reject_header_size + load_le<std::uint32_t>(data + 4);
+        case BinaryMessage::book_summary:
+            require_size(size, binary_book_summary_header_size);
+            return binary_book_summary_header_size +
+                   (std::size_t{load_le<std::uint32_t>(data + 4)} + load_le<std::uint32_t>(data + 8)) * binary_level_size;
+        case BinaryMessage::snapshot:
+        case BinaryMessage::update:
+            require_size(size, binary_market_data_header_size);
+            return binary_market_data_header_size +
+                   (std::size_t{load_le<std::uint32_t>(data + 4)} + load_le<std::uint32_t>(data + 8)) * binary_level_size +
+                   std::size_t{load_le<std::uint32_t>(data + 12)} * binary_trade_size;
+        default:
+            throw std::runtime_error("Unknown binary response type");
+        }
+    }
+
+    void describe_levels(std::string &text, const char *label, const OrderLevels &levels)
+    {
+        text += label;
+        for (const auto &level : levels)
+            text += " " + std::to_string(level.quantity) + "@" + std::to_string(level.price);
+    }
+}
+
+const char *order_status_name(OrderStatus status)
+{
+    switch (status)
+    {
+    case OrderStatus::open:
+        return "open";
+    case OrderStatus::partially_filled:
+        return "partially_filled";
+    case OrderStatus::filled:
+        return "filled";
+    case OrderStatus::canceled:
+        return "canceled";
+    }
+    return "unknown";
+}
+
+BinaryRequest decode_binary_request(const unsigned char *data, std::size_t size)
+{
+    require_size(size, 1);
+    BinaryRequest request;
+    request.type = static_cast<BinaryMessage>(data[0]);
+    switch (request.type)
+    {
+    case BinaryMessage::new_order:
+        require_size(size, binary_new_order_size);
+        request.order_type = read_order_type(data[1]);
+        request.side = read_side(data[2]);
+        request.quantity = load_le<Quantity>(data + 4);
+        request.id = load_le<OrderID>(data + 8);
+        request.price = load_le<Price>(data + 16);
+        if (request.order_type == OrderType::stop || request.order_type == OrderType::stop_limit)
+            request.stop_price = load_le<Price>(data + 20);
+        else if (request.order_type == OrderType::iceberg)
+            request.display_quantity = load_le<Quantity>(data + 20);
+        request.symbol = read_symbol(data + 24);
+        break;
+    case BinaryMessage::cancel:
+        require_size(size, binary_cancel_size);
+        request.id = load_le<OrderID>(data + 8);
+        request.symbol = read_symbol(data + 16);
+        break;
+    case BinaryMessage::modify:
+        require_size(size, binary_modify_size);
+        request.quantity = load_le<Quantity>(data + 4);
+        request.id = load_le<OrderID>(data + 8);
+        request.price = load_le<Price>(data + 16);
+        request.symbol = read_symbol(data + 24);
+        break;
+    case BinaryMessage::summary:
+        require_size(size, binary_summary_size);
+        request.depth = load_le<std::uint32_t>(data + 4);
+        request.symbol = read_symbol(data + 8);
+        break;
+    case BinaryMessage::subscribe:
+    case BinaryMessage::unsubscribe:
+        require_size(size, binary_subscribe_size);
+        request.symbol = read_symbol(data + 8);
+        break;
+    default:
+        throw std::runtime_error("Unknown binary request type");
+    }
+    return request;
+}
+
+BinaryResponse decode_binary_response(const unsigned char *data, std::size_t size)
+{
+    require_size(size, 1);
+    BinaryResponse response;
+    response.type = static_cast<BinaryMessage>(data[0]);
+    switch (response.type)
+    {
+    case BinaryMessage::execution_report:
+        require_size(size, binary_execution_report_size);
+        response.request = static_cast<BinaryMessage>(data[1]);
+        response.status = static_cast<OrderStatus>(data[2]);
+        response.filled = load_le<Quantity>(data + 4);
+        response.id = load_le<OrderID>(data + 8);
+        response.trade_count = load_le<std::uint32_t>(data + 16);
+        break;
+    case BinaryMessage::reject:
+    {
+        require_size(size, binary_reject_header_size);
+        response.request = static_cast<BinaryMessage>(data[1]);
+        std::uint32_t length = load_le<std::uint32_t>(data + 4);
+        response.id = load_le<OrderID>(data + 8);
+        require_size(size, binary_reject_header_size + length);
+        response.error.assign(reinterpret_cast<const char *>(data + binary_reject_header_size), length);
+        break;
+    }
+    case BinaryMessage::book_summary:
+    {
+        require_size(size, binary_book_summary_header_size);
+        std::uint32_t bid_count = load_le<std::uint32_t>(data + 4);
+        std::uint32_t ask_count = load_le<std::uint32_t>(data + 8);
+        require_size(size, binary_book_summary_header_size +
+                               (std::size_t{bid_count} + ask_count) * binary_level_size);
+        const unsigned char *levels = data + binary_book_summary_header_size;
+        read_levels(levels, bid_count, response.bids);
+        read_levels(levels + std::size_t{bid_count} * binary_level_size, ask_count, response.asks);
+        break;
+    }
+    case BinaryMessage::snapshot:
+    case BinaryMessage::update:
+    {
+        require_size(size, binary_market_data_header_size);
+        std::uint32_t bid_count = load_le<std::uint32_t>(data + 4);
+        std::uint32_t ask_count = load_le<std::uint32_t>(data + 8);
+        std::uint32_t trade_count = load_le<std::uint32_t>(data + 12);
+        require_size(size, response_size(data, size));
+        response.sequence = load_le<std::uint64_t>(data + 16);
+        response.symbol = read_symbol(data + 24);
+        const unsigned char *levels = data + binary_market_data_header_size;
+        read_levels(levels, bid_count, response.bids);
+        read_levels(levels + std::size_t{bid_count} * binary_level_size, ask_count, response.asks);
+        const unsigned char *trades = levels + (std::size_t{bid_count} + ask_count) * binary_level_size;
+        response.trades.reserve(trade_count);
+        for (std::uint32_t i = 0; i < trade_count; ++i, trades += binary_trade_size)
+            response.trades.emplace_back(load_le<OrderID>(trades), load_le<OrderID>(trades + 8),
+                                         load_le<Price>(trades + 16), load_le<Quantity>(trades + 20));
+        break;
+    }
+    case BinaryMessage::batch_report:
+    {
+        require_size(size, binary_batch_header_size);
+        std::uint32_t count = load_le<std::uint32_t>(data + 4);
+        std::size_t offset = binary_batch_header_size;
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            std::size_t item_size = response_size(data + offset, size - offset);
+            require_size(size - offset, item_size);
+            response.items.push_back(decode_binary_response(data + offset, item_size));
+            offset += item_size;
+        }
+        break;
+    }
+    default:
+        throw std::runtime_error("Unknown binary response type");
+    }
+    return response;
+}
+
+void encode_new_order(std::string &out, const Symbol &symbol, OrderID id, OrderType type,
+                      OrderSide side, Price price, Quantity quantity, Price stop_price,
+                      Quantity display_quantity)
+{
+    unsigned char *data = append(out, binary_new_order_size);
+    data[0] = static_cast<unsigned char>(BinaryMessage::new_order);
+    data[1] = static_cast<unsigned char>(type);
+    data[2] = static_cast<unsigned char>(side);
+    store_le(data + 4, quantity);
+    store_le(data + 8, id);
+    store_le(data + 16, price);
+    if (type == OrderType::stop || type == OrderType::stop_limit)
+        store_le(data + 20, stop_price);
+    else if (type == OrderType::iceberg)
+        store_le(data + 20, display_quantity);
+    write_symbol(data + 24, symbol);
+}
+
+void encode_cancel(std::string &out, const Symbol &symbol, OrderID id)
+{
+    unsigned char *data = append(out, binary_cancel_size);
+    data[0] = static_cast<unsigned char>(BinaryMessage::cancel);
+    store_le(data + 8, id);
+    write_symbol(data + 16, symbol);
+}
+
+void encode_modify(std::string &out, const Symbol &symbol, OrderID id, Price price, Quantity quantity)
+{
+    unsigned char *data = append(out, binary_modify_size);
+    data[0] = static_cast<unsigned char>(BinaryMessage::modify);
+    store_le(data + 4, quantity);
+    store_le(data + 8, id);
+    store_le(data + 16, price);
+    write_symbol(data + 24, symbol);
+}
+
+void encode_summary(std::string &out, const Symbol &symbol, std::uint32_t depth)
+{
+    unsigned char *data = append(out, binary_summary_size);
+    data[0] = static_cast<unsigned char>(BinaryMessage::summary);
+    store_le(data + 4, depth);
+    write_symbol(data + 8, symbol);
+}
+
+void encode_subscribe(std::string &out, BinaryMessage type, const Symbol &symbol)
+{
+    unsigned char *data = append(out, binary_subscribe_size);
+    data[0] = static_cast<unsigned char>(type);
+    write_symbol(data + 8, symbol);
+}
+
+void encode_batch_header(std::string &out, BinaryMessage type, std::uint32_t count)
+{
+    unsigned char *data = append(out, binary_batch_header_size);
+    data[0] = static_cast<unsigned char>(type);
+    store_le(data + 4, count);
+}
+
+std::size_t binary_request_size(BinaryMessage type)
+{
+    switch (type)
+    {
+    case BinaryMessage::new_order:
+        return binary_new_order_size;
+    case BinaryMessage::cancel:
+        return binary_cancel_size;
+    case BinaryMessage::modify:
+        return binary_modify_size;
+    case BinaryMessage::summary:
+        return binary_summary_size;
+    case BinaryMessage::subscribe:
+    case BinaryMessage::unsubscribe:
+        return binary_subscribe_size;
+    default:
+        return 0;
+    }
+}
+
+void encode_execution_report(std::string &out, BinaryMessage request, OrderID id, OrderStatus status,
+                             Quantity filled, std::uint32_t trade_count)
+{
+    unsigned char *data = append(out, binary_execution_report_size);
+    data[0] = static_cast<unsigned char>(BinaryMessage::execution_report);
+    data[1] = static_cast<unsigned char>(request);
+    data[2] = static_cast<unsigned char>(status);
+    store_le(data + 4, filled);
+    store_le(data + 8, id);
+    store_le(data + 16, trade_count);
+}
+
+void encode_reject(std::string &out, BinaryMessage request, OrderID id, std::string_view text)
+{
+    unsigned char *data = append(out, binary_reject_header_size + text.size());
+    data[0] = static_cast<unsigned char>(BinaryMessage::reject);
+    data[1] = static_cast<unsigned char>(request);
+    store_le(data + 4, static_cast<std::uint32_t>(text.size()));
+    store_le(data + 8, id);
+    std::memcpy(data + binary_reject_header_size, text.data(), text.size());
+}
+
+void encode_book_summary(std::string &out, const OrderLevels &bids, const OrderLevels &asks)
+{
+    unsigned char *data = append(out, binary_book_summary_header_size +
+                                          (bids.size() + asks.size()) * binary_level_size);
+    data[0] = static_cast<unsigned char>(BinaryMessage::book_summary);
+    store_le(data + 4, static_cast<std::uint32_t>(bids.size()));
+    store_le(data + 8, static_cast<std::uint32_t>(asks.size()));
+    write_levels(write_levels(data + binary_book_summary_header_size, bids), asks);
+}
+
+void encode_market_data(std::string &out, BinaryMessage type, const Symbol &symbol, std::uint64_t sequence,
+                        const OrderLevels &bids, const OrderLevels &asks, const std::vector<Trade> &trades)
+{
+    unsigned char *data = append(out, binary_market_data_header_size +
+                                          (bids.size() + asks.size()) * binary_level_size +
+                                          trades.size() * binary_trade_size);
+    data[0] = static_cast<unsigned char>(type);
+    store_le(data + 4, static_cast<std::uint32_t>(bids.size()));
+    store_le(data + 8, static_cast<std::uint32_t>(asks.size()));
+    store_le(data + 12, static_cast<std::uint32_t>(trades.size()));
+    store_le(data + 16, sequence);
+    write_symbol(data + 24, symbol);
+    unsigned char *trade_data = write_levels(write_levels(data + binary_market_data_header_size, bids), asks);
+    for (const auto &trade : trades)
+    {
+        store_le(trade_data, trade.get_bid_order_id());
+        store_le(trade_data + 8, trade.get_ask_order_id());
+        store_le(trade_data + 16, trade.get_price());
+        store_le(trade_data + 20, trade.get_quantity());
+        trade_data += binary_trade_size;
+    }
+}
+
+std::string describe_binary_response(const BinaryResponse &response)
+{
+    std::string text;
+    switch (response.type)
+    {
+    case BinaryMessage::execution_report:
+        text = "report id=" + std::to_string(response.id) + " status=" + order_status_name(response.status) +
+               " filled=" + std::to_string(response.filled) + " trades=" + std::to_string(response.trade_count);
+        break;
+    case BinaryMessage::reject:
+        text = "reject id=" + std::to_string(response.id) + " error=" + response.error;
+        break;
+    case BinaryMessage::book_summary:
+        text = "summary";
+        describe_levels(text, " bids=", response.bids);
+        describe_levels(text, " asks=", response.asks);
+        break;
+    case BinaryMessage::snapshot:
+    case BinaryMessage::update:
+        text = std::string(response.type == BinaryMessage::snapshot ? "snapshot " : "update ") +
+               std::string(response.symbol.view()) + " seq=" + std::to_string(response.sequence);
+        describe_levels(text, " bids=", response.bids);
+        describe_levels(text, " asks=", response.asks);
+        for (const auto &trade : response.trades)
+            text += " trade " + std::to_string(trade.get_quantity()) + "@" + std::to_string(trade.get_price());
+        break;
+    case BinaryMessage::batch_report:
+        text = "batch of " + std::to_string(response.items.size()) + ":";
+        for (const auto &item : response.items)
+            text += "\n  " + describe_binary_response(item);
+        break;
+    default:
+        text = "unknown message";
+        break;
+    }
+    return text;
+}
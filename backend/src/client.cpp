@@ -7,6 +7,7 @@
 #include <deque>
 #include <thread>
 #include <mutex>
+#include "binary_protocol.hpp"
 #include "order.hpp"
 
 namespace beast = boost::beast;
@@ -22,10 +23,20 @@ class AsyncWebSocketClient : public std::enable_shared_from_this<AsyncWebSocketC
     beast::flat_buffer buffer_;
     std::deque<std::string> write_msgs_;
     std::mutex write_mutex_;
+    bool binary_;
 
 public:
-    AsyncWebSocketClient(net::io_context &ioc)
-        : ioc_(ioc), ws_(ioc) {}
+    AsyncWebSocketClient(net::io_context &ioc, bool binary)
+        : ioc_(ioc), ws_(ioc), binary_(binary)
+    {
+        if (binary_)
+        {
+            ws_.set_option(websocket::stream_base::decorator([](websocket::request_type &request) {
+                request.set(beast::http::field::sec_websocket_protocol, binary_subprotocol);
+            }));
+            ws_.binary(true);
+        }
+    }
 
     void run(const std::string &host, const std::string &port, const std::string &target = "/")
     {
@@ -80,9 +91,8 @@ private:
             {
                 if(!ec)
                 {
-                    std::string response = beast::buffers_to_string(self->buffer_.data());
+                    std::cout << "Received: " << self->describe_frame() << std::endl;
                     self->buffer_.consume(self->buffer_.size());
-                    std::cout << "Received: " << response << std::endl;
                     self->do_read();
                 }
                 else
@@ -92,6 +102,22 @@ private:
             });
     }
 
+    std::string describe_frame() const
+    {
+        if (!binary_)
+            return beast::buffers_to_string(buffer_.data());
+        try
+        {
+            auto frame = buffer_.data();
+            return describe_binary_response(
+                decode_binary_response(static_cast<const unsigned char *>(frame.data()), frame.size()));
+        }
+        catch (const std::exception &e)
+        {
+            return std::string("undecodable frame: ") + e.what();
+        }
+    }
+
     void do_write()
     {
         std::lock_guard<std::mutex> lock(write_mutex_);
@@ -115,10 +141,13 @@ private:
     }
 };
 
-int main()
+int main(int argc, char *argv[])
 {
+    // Pass --binary to speak the compact binary protocol instead of JSON.
+    bool binary = argc > 1 && std::string(argv[1]) == "--binary";
+
     net::io_context ioc;
-    auto client = std::make_shared<AsyncWebSocketClient>(ioc);
+    auto client = std::make_shared<AsyncWebSocketClient>(ioc, binary);
     client->run("127.0.0.1", "8080");
 
     // Run the io_context in a separate thread.
@@ -133,33 +162,133 @@ int main()
             break;
         else if(line == "summary")
         {
-            json::object summary_cmd;
-            summary_cmd["command"] = "summary";
-            client->send(json::serialize(summary_cmd));
+            std::string message;
+            if(binary)
+                encode_summary(message, default_symbol, 0);
+            else
+            {
+                json::object summary_cmd;
+                summary_cmd["command"] = "summary";
+                message = json::serialize(summary_cmd);
+            }
+            client->send(message);
+        }
+        else if(line == "stats")
+        {
+            // Server statistics are only reported as JSON.
+            if(binary)
+            {
+                std::cout << "stats is not available over the binary protocol." << std::endl;
+                continue;
+            }
+            json::object stats_cmd;
+            stats_cmd["command"] = "stats";
+            client->send(json::serialize(stats_cmd));
+        }
+        else if(line.find("analytics") == 0)
+        {
+            // Expected format: analytics [symbol]; reported as JSON only.
+            if(binary)
+            {
+                std::cout << "analytics is not available over the binary protocol." << std::endl;
+                continue;
+            }
+            std::istringstream iss(line);
+            std::string command, symbol;
+            iss >> command >> symbol;
+            json::object analytics_cmd;
+            analytics_cmd["command"] = "analytics";
+            if(!symbol.empty())
+                analytics_cmd["symbol"] = symbol;
+            client->send(json::serialize(analytics_cmd));
+        }
+        else if(line.find("trades") == 0 || line.find("bars") == 0)
+        {
+            // Expected format: trades [symbol] / bars <1s|1m|5m> [symbol]; reported as JSON only.
+            if(binary)
+            {
+                std::cout << "trade history is not available over the binary protocol." << std::endl;
+                continue;
+            }
+            std::istringstream iss(line);
+            std::string command, resolution, symbol;
+            iss >> command;
+            if(command == "bars")
+                iss >> resolution;
+            iss >> symbol;
+            json::object history_cmd;
+            history_cmd["command"] = command;
+            if(!resolution.empty())
+                history_cmd["resolution"] = resolution;
+            if(!symbol.empty())
+                history_cmd["symbol"] = symbol;
+            client->send(json::serialize(history_cmd));
+        }
+        else if(line.find("subscribe") == 0 || line.find("unsubscribe") == 0)
+        {
+            // Expected format: subscribe [symbol] / unsubscribe [symbol]
+            std::istringstream iss(line);
+            std::string command, symbol;
+            iss >> command >> symbol;
+            std::string message;
+            if(binary)
+                encode_subscribe(message, command == "subscribe" ? BinaryMessage::subscribe : BinaryMessage::unsubscribe,
+                                 symbol.empty() ? default_symbol : Symbol(symbol));
+            else
+            {
+                json::object subscribe_cmd;
+                subscribe_cmd["command"] = command;
+                if(!symbol.empty())
+                    subscribe_cmd["symbol"] = symbol;
+                message = json::serialize(subscribe_cmd);
+            }
+            client->send(message);
         }
         else if(line.find("send") == 0)
         {
-            // Expected format: send <type> <side> <price> <quantity>
+            // Expected format: send <type> <side> <price> <quantity> [stop price | display quantity]
+            // The extra field is the stop price for STOP and STOP_LIMIT and the display quantity for ICEBERG.
             std::istringstream iss(line);
             std::string command, type, side;
-            int price, quantity;
-            iss >> command >> type >> side >> price >> quantity;
+            int price, quantity, extra = 0;
+            iss >> command >> type >> side >> price >> quantity >> extra;
+            bool stop = type == "STOP" || type == "STOP_LIMIT";
+            if(binary)
+            {
+                OrderType order_type = (type == "GTC")          ? OrderType::good_till_cancel
+                                       : (type == "FOK")        ? OrderType::fill_or_kill
+                                       : (type == "STOP")       ? OrderType::stop
+                                       : (type == "STOP_LIMIT") ? OrderType::stop_limit
+                                       : (type == "ICEBERG")    ? OrderType::iceberg
+                                                                : OrderType::immediate_or_cancel;
+                std::string message;
+                encode_new_order(message, default_symbol, order_id++, order_type,
+                                 side == "buy" ? OrderSide::buy : OrderSide::sell, price, quantity,
+                                 extra, static_cast<Quantity>(extra));
+                client->send(message);
+                continue;
+            }
             json::object order_msg;
             order_msg["id"] = std::to_string(order_id++);
             order_msg["type"] = type;
             order_msg["side"] = side;
             order_msg["price"] = price;
             order_msg["quantity"] = quantity;
+            if(stop)
+                order_msg["stop_price"] = extra;
+            else if(type == "ICEBERG")
+                order_msg["display_quantity"] = extra;
             client->send(json::serialize(order_msg));
         }
         else
         {
-            std::cout << "Unknown command. Use 'send <type> <side> <price> <quantity>', 'summary', or 'quit'." << std::endl;
+            std::cout << "Unknown command. Use 'send <type> <side> <price> <quantity> [stop price | display quantity]', 'summary', 'stats', 'analytics [symbol]', 'trades [symbol]', 'bars <1s|1m|5m> [symbol]', 'subscribe [symbol]', 'unsubscribe [symbol]', or 'quit'." << std::endl;
         }
     }
 
     // Optionally, send a close message if needed.
-    client->send("{\"command\": \"quit\"}");
+    if(!binary)
+        client->send("{\"command\": \"quit\"}");
     ioc.stop();
     io_thread.join();
     return 0;
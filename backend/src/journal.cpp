@@ -0,0 +1,294 @@
+#include "journal.hpp"
+#include "byte_order.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Record layout, little-endian:
+//   sequence u64 | id u64 | price i32 | quantity u32 | command u8 | type u8 | side u8 | pad u8
+//   | checksum u32 | symbol[16]
+// The checksum is FNV-1a over every other byte of the record. A parameters
+// record has the same layout with the stop price in `price` and the display
+// quantity in `quantity`.
+
+namespace
+{
+    constexpr std::size_t checksum_offset = 28;
+    constexpr std::size_t symbol_offset = 32;
+
+    std::uint32_t record_checksum(const unsigned char *data)
+    {
+        std::uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < Journal::record_size; ++i)
+        {
+            if (i >= checksum_offset && i < symbol_offset)
+                continue;
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    [[noreturn]] void throw_system_error(const std::string &what, const std::string &path)
+    {
+        throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+    }
+
+    std::size_t page_size()
+    {
+        static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+}
+
+Journal::Journal(const JournalConfig &config) : config_(config)
+{
+    if (config_.directory.empty())
+        throw std::invalid_argument("Journal directory must be set");
+    if (config_.segment_size < 2 * record_size)
+        throw std::invalid_argument("Journal segment size must hold at least two records");
+    // Whole records only, so a record never straddles two segments.
+    config_.segment_size -= config_.segment_size % record_size;
+
+    std::filesystem::create_directories(config_.directory);
+    std::vector<std::uint64_t> segments = list_segments(config_.directory);
+    if (segments.empty())
+    {
+        open_segment(0);
+        return;
+    }
+
+    // The newest segment holding a record carries the last sequence; later
+    // ones can only be empty, left by a crash right after a roll-over.
+    JournalEntry entry;
+    for (auto it = segments.rbegin(); it != segments.rend() && last_sequence_ == 0; ++it)
+    {
+        MappedFile segment(segment_path(config_.directory, *it));
+        for (std::size_t offset = 0; offset + record_size <= segment.size(); offset += record_size)
+        {
+            if (!decode(segment.data() + offset, entry))
+                break;
+            last_sequence_ = entry.sequence;
+        }
+    }
+
+    open_segment(segments.back());
+    while (offset_ + record_size <= config_.segment_size && decode(data_ + offset_, entry))
+        offset_ += record_size;
+
+    // Anything past the last valid record is a torn write; pages written
+    // after it may have reached the disk first, so clear them before they
+    // could be mistaken for records following the new ones.
+    unsigned char *tail = data_ + offset_;
+    std::size_t tail_size = config_.segment_size - offset_;
+    if (std::any_of(tail, tail + tail_size, [](unsigned char byte) { return byte != 0; }))
+    {
+        std::memset(tail, 0, tail_size);
+        sync_range(offset_, config_.segment_size);
+    }
+    synced_offset_ = offset_;
+}
+
+Journal::~Journal()
+{
+    try
+    {
+        commit();
+    }
+    catch (const std::exception &)
+    {
+        // Nothing sensible to do this late; records stay in the page cache.
+    }
+    close_segment();
+}
+
+std::uint64_t Journal::append(JournalEntry entry)
+{
+    bool with_parameters = entry.command == JournalCommand::add &&
+                           (entry.type == OrderType::stop || entry.type == OrderType::stop_limit ||
+                            entry.type == OrderType::iceberg);
+    // A parameters record and its add share a segment, so replay sees them together.
+    std::size_t records = with_parameters ? 2 : 1;
+    if (offset_ + records * record_size > config_.segment_size)
+    {
+        commit();
+        close_segment();
+        open_segment(segment_index_ + 1);
+    }
+
+    if (with_parameters)
+    {
+        JournalEntry parameters = entry;
+        parameters.command = JournalCommand::parameters;
+        parameters.price = entry.stop_price;
+        parameters.quantity = entry.display_quantity;
+        parameters.sequence = ++last_sequence_;
+        encode(data_ + offset_, parameters);
+        offset_ += record_size;
+    }
+
+    entry.sequence = ++last_sequence_;
+    encode(data_ + offset_, entry);
+    offset_ += record_size;
+
+    if (config_.sync == JournalSync::every)
+        commit();
+    return entry.sequence;
+}
+
+void Journal::commit()
+{
+    if (config_.sync == JournalSync::none || synced_offset_ == offset_)
+        return;
+    sync_range(synced_offset_, offset_);
+    synced_offset_ = offset_;
+}
+
+void Journal::discard_through(std::uint64_t sequence)
+{
+    std::vector<std::uint64_t> segments = list_segments(config_.directory);
+    // A segment is covered when the one after it starts no later than `sequence + 1`.
+    for (std::size_t i = 0; i + 1 < segments.size() && segments[i] < segment_index_; ++i)
+    {
+        std::uint64_t next = first_sequence(config_.directory, segments[i + 1]);
+        if (next == 0 || next > sequence + 1)
+            break;
+        std::filesystem::remove(segment_path(config_.directory, segments[i]));
+    }
+}
+
+std::string Journal::segment_path(const std::string &directory, std::uint64_t index)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "journal-%06llu.log", static_cast<unsigned long long>(index));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+std::vector<std::uint64_t> Journal::list_segments(const std::string &directory)
+{
+    std::vector<std::uint64_t> indexes;
+    std::error_code error;
+    for (const auto &file : std::filesystem::directory_iterator(directory, error))
+    {
+        std::string name = file.path().filename().string();
+        unsigned long long index = 0;
+        int consumed = 0;
+        if (std::sscanf(name.c_str(), "journal-%llu.log%n", &index, &consumed) == 1 &&
+            static_cast<std::size_t>(consumed) == name.size())
+            indexes.push_back(index);
+    }
+    std::sort(indexes.begin(), indexes.end());
+    return indexes;
+}
+
+std::uint64_t Journal::first_sequence(const std::string &directory, std::uint64_t index)
+{
+    MappedFile segment(segment_path(directory, index));
+    JournalEntry entry;
+    if (segment.size() < record_size || !decode(segment.data(), entry))
+        return 0;
+    return entry.sequence;
+}
+
+bool Journal::decode(const unsigned char *data, JournalEntry &entry)
+{
+    entry.sequence = load_le<std::uint64_t>(data);
+    if (entry.sequence == 0 || load_le<std::uint32_t>(data + checksum_offset) != record_checksum(data))
+        return false;
+
+    entry.id = load_le<std::uint64_t>(data + 8);
+    entry.price = load_le<std::int32_t>(data + 16);
+    entry.quantity = load_le<std::uint32_t>(data + 20);
+    entry.command = static_cast<JournalCommand>(data[24]);
+    entry.type = static_cast<OrderType>(data[25]);
+    entry.side = static_cast<OrderSide>(data[26]);
+    entry.stop_price = 0;
+    entry.display_quantity = 0;
+    const char *symbol = reinterpret_cast<const char *>(data + symbol_offset);
+    std::size_t length = strnlen(symbol, Symbol::max_length);
+    if (length == 0)
+        return false;
+    entry.symbol = Symbol(std::string_view(symbol, length));
+    return true;
+}
+
+void Journal::merge_parameters(const JournalEntry &parameters, JournalEntry &entry)
+{
+    if (entry.command != JournalCommand::add || parameters.command != JournalCommand::parameters ||
+        parameters.sequence + 1 != entry.sequence || parameters.id != entry.id)
+        return;
+    entry.stop_price = parameters.price;
+    entry.display_quantity = parameters.quantity;
+}
+
+void Journal::encode(unsigned char *data, const JournalEntry &entry)
+{
+    unsigned char record[record_size] = {};
+    store_le<std::uint64_t>(record, entry.sequence);
+    store_le<std::uint64_t>(record + 8, entry.id);
+    store_le<std::int32_t>(record + 16, entry.price);
+    store_le<std::uint32_t>(record + 20, entry.quantity);
+    record[24] = static_cast<unsigned char>(entry.command);
+    record[25] = static_cast<unsigned char>(entry.type);
+    record[26] = static_cast<unsigned char>(entry.side);
+    std::string_view symbol = entry.symbol.view();
+    std::memcpy(record + symbol_offset, symbol.data(), symbol.size());
+    store_le<std::uint32_t>(record + checksum_offset, record_checksum(record));
+    std::memcpy(data, record, record_size);
+}
+
+void Journal::open_segment(std::uint64_t index)
+{
+    std::string path = segment_path(config_.directory, index);
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0)
+        throw_system_error("Cannot open journal segment", path);
+
+    struct stat info;
+    if (::fstat(fd_, &info) != 0)
+        throw_system_error("Cannot stat journal segment", path);
+    if (static_cast<std::size_t>(info.st_size) < config_.segment_size)
+    {
+        // Reserve the blocks up front: a store into a hole the disk cannot back would fault.
+        int error = ::posix_fallocate(fd_, 0, static_cast<off_t>(config_.segment_size));
+        if (error != 0)
+        {
+            errno = error;
+            throw_system_error("Cannot preallocate journal segment", path);
+        }
+        if (config_.sync != JournalSync::none && ::fsync(fd_) != 0)
+            throw_system_error("Cannot sync journal segment", path);
+    }
+
+    void *mapping = ::mmap(nullptr, config_.segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED)
+        throw_system_error("Cannot map journal segment", path);
+    data_ = static_cast<unsigned char *>(mapping);
+    segment_index_ = index;
+    offset_ = 0;
+    synced_offset_ = 0;
+}
+
+void Journal::close_segment()
+{
+    if (data_)
+        ::munmap(data_, config_.segment_size);
+    if (fd_ >= 0)
+        ::close(fd_);
+    data_ = nullptr;
+    fd_ = -1;
+}
+
+void Journal::sync_range(std::size_t from, std::size_t to)
+{
+    // msync wants a page-aligned start.
+    std::size_t start = from - from % page_size();
+    if (::msync(data_ + start, to - start, MS_SYNC) != 0)
+        throw_system_error("Cannot sync journal segment", segment_path(config_.directory, segment_index_));
+}
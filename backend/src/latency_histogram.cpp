@@ -0,0 +1,52 @@
+#include "latency_histogram.hpp"
+#include <cmath>
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (std::size_t i = 0; i < bucket_count; ++i)
+        counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::reset()
+{
+    counts_.fill(0);
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+double LatencyHistogram::mean() const
+{
+    return count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_);
+}
+
+std::uint64_t LatencyHistogram::percentile(double percentile) const
+{
+    if (count_ == 0)
+        return 0;
+    double clamped = std::clamp(percentile, 0.0, 100.0);
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(count_)));
+    rank = std::max<std::uint64_t>(rank, 1);
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucket_count; ++i)
+    {
+        seen += counts_[i];
+        if (seen >= rank)
+            return std::min(bucket_upper_bound(i), max_);
+    }
+    return max_;
+}
+
+std::uint64_t LatencyHistogram::bucket_upper_bound(std::size_t index)
+{
+    if (index < sub_bucket_count)
+        return index;
+    std::size_t above = index - sub_bucket_count;
+    unsigned shift = static_cast<unsigned>(above / sub_bucket_half) + 1;
+    std::uint64_t sub_bucket = sub_bucket_half + above % sub_bucket_half;
+    return ((sub_bucket + 1) << shift) - 1;
+}
@@ -0,0 +1,672 @@
+// Open-loop load generator: many WebSocket connections sending a mix of
+// adds, cancels and modifies at a fixed aggregate rate, recording the
+// round-trip latency of every request in log-linear histograms.
+//
+// Usage: loadgen [--host H] [--port P] [--connections C] [--rate R]
+//                [--duration S] [--warmup S] [--threads T] [--binary]
+//                [--mix ADD:CANCEL:MODIFY] [--types GTC:IOC:FOK]
+//                [--symbols N] [--seed N]
+//
+// Each connection sends on its own fixed schedule (R / C requests per
+// second, offset from the others) whether or not earlier replies have
+// arrived, and latency is measured from the time a request was due rather
+// than when it was written. A stalled server therefore shows up as the
+// queueing delay its clients would really see instead of as fewer, faster
+// samples (coordinated omission). Replies are matched to requests by order
+// id, so the order in which shards answer does not matter.
+//
+// Cancels and modifies pick from the GTC orders the connection believes are
+// resting. An order leaves that set when it is canceled, when its add is
+// answered as filled, and when a modify of it is rejected, which is how an
+// order filled later by someone else's trade is noticed. Rejected requests
+// are counted per command and kept out of the latency histograms, so the
+// cheap error path does not dilute the latencies of real work.
+//
+// Output is key=value lines: the run configuration, the totals with offered
+// and achieved rates and rejects per command, and one latency line per
+// command plus one for all, in microseconds. Requests due during the
+// warm-up are sent but not measured.
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/asio.hpp>
+#include <boost/json.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "binary_protocol.hpp"
+#include "latency_histogram.hpp"
+
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+namespace net = boost::asio;
+namespace json = boost::json;
+using tcp = net::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    enum class Command : std::uint8_t
+    {
+        add,
+        cancel,
+        modify
+    };
+    constexpr std::array<const char *, 3> command_names = {"add", "cancel", "modify"};
+
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        std::string port = "8080";
+        std::size_t connections = 8;
+        double rate = 10000;          // requests per second over all connections
+        double duration = 10;         // seconds of sending, warm-up included
+        double warmup = 1;            // seconds not measured
+        double drain = 2;             // seconds to wait for late replies
+        std::size_t threads = 1;
+        bool binary = false;
+        std::array<unsigned, 3> mix = {60, 25, 15};  // add : cancel : modify
+        std::array<unsigned, 3> types = {80, 15, 5}; // GTC : IOC : FOK
+        std::size_t symbols = 1;
+        std::uint64_t seed = 1;
+    };
+
+    // Per-thread totals, merged once every connection has finished.
+    struct Results
+    {
+        std::uint64_t sent = 0;
+        std::uint64_t received = 0;
+        std::uint64_t rejected = 0;
+        std::array<std::uint64_t, 3> rejected_by_command{};
+        std::uint64_t unmatched = 0; // replies with no request waiting on their id
+        std::uint64_t lost = 0;      // requests still unanswered when the drain ended
+        std::uint64_t failed_connections = 0;
+        Clock::time_point last_reply{};
+        std::array<LatencyHistogram, 3> latency;
+
+        void merge(const Results &other)
+        {
+            sent += other.sent;
+            received += other.received;
+            rejected += other.rejected;
+            for (std::size_t i = 0; i < rejected_by_command.size(); ++i)
+                rejected_by_command[i] += other.rejected_by_command[i];
+            unmatched += other.unmatched;
+            lost += other.lost;
+            failed_connections += other.failed_connections;
+            last_reply = std::max(last_reply, other.last_reply);
+            for (std::size_t i = 0; i < latency.size(); ++i)
+                latency[i].merge(other.latency[i]);
+        }
+    };
+
+    // "a:b:c" into three weights.
+    std::array<unsigned, 3> parse_ratio(const std::string &text)
+    {
+        std::array<unsigned, 3> ratio{};
+        std::istringstream in(text);
+        char colon1 = 0;
+        char colon2 = 0;
+        if (!(in >> ratio[0] >> colon1 >> ratio[1] >> colon2 >> ratio[2]) || colon1 != ':' || colon2 != ':' ||
+            ratio[0] + ratio[1] + ratio[2] == 0)
+            throw std::invalid_argument("Expected a ratio like 60:25:15, got " + text);
+        return ratio;
+    }
+
+    class Connection
+    {
+        // A request waiting for its reply.
+        struct Outstanding
+        {
+            Clock::time_point due;
+            Command command;
+        };
+
+        struct LiveOrder
+        {
+            OrderID id;
+            std::size_t symbol;
+        };
+
+    public:
+        Connection(net::io_context &ioc, const Options &options, const std::vector<Symbol> &symbols,
+                   std::size_t index, Clock::time_point start, Results &results)
+            : options_(options), symbols_(symbols), ws_(ioc), timer_(ioc), results_(results),
+              next_id_((static_cast<OrderID>(index) + 1) << 40),
+              gen_(options.seed * 1000003 + index),
+              command_dist_(options.mix.begin(), options.mix.end()),
+              type_dist_(options.types.begin(), options.types.end())
+        {
+            interval_ = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(options.connections) / options.rate));
+            // Spread the connections evenly over one interval so their sends do not coincide.
+            next_due_ = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(index) / options.rate));
+            measure_from_ = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmup));
+            stop_at_ = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+
+            if (options_.binary)
+            {
+                ws_.set_option(websocket::stream_base::decorator([](websocket::request_type &request) {
+                    request.set(beast::http::field::sec_websocket_protocol, binary_subprotocol);
+                }));
+                ws_.binary(true);
+            }
+        }
+
+        void run(const tcp::resolver::results_type &endpoints)
+        {
+            net::async_connect(ws_.next_layer(), endpoints,
+                [this](boost::system::error_code ec, const tcp::endpoint &) {
+                    if (ec)
+                        return fail("Connect", ec);
+                    ws_.next_layer().set_option(tcp::no_delay(true));
+                    ws_.async_handshake(options_.host, "/", [this](boost::system::error_code ec) {
+                        if (ec)
+                            return fail("Handshake", ec);
+                        open_ = true;
+                        do_read();
+                        send_due();
+                    });
+                });
+        }
+
+        bool closed() const { return closed_; }
+
+        // Gives up on whatever is still unanswered.
+        void stop()
+        {
+            if (closed_)
+                return;
+            abandon_outstanding();
+            close();
+        }
+
+    private:
+        void fail(const char *what, boost::system::error_code ec)
+        {
+            std::cerr << what << " error: " << ec.message() << std::endl;
+            ++results_.failed_connections;
+            abandon_outstanding();
+            closed_ = true;
+        }
+
+        void abandon_outstanding()
+        {
+            for (const auto &[id, waiting] : outstanding_)
+                results_.lost += waiting.size();
+            outstanding_.clear();
+        }
+
+        // Sends every request whose due time has passed, then sleeps until the next one.
+        void send_due()
+        {
+            if (closed_)
+                return;
+            Clock::time_point now = Clock::now();
+            while (next_due_ <= now && next_due_ < stop_at_)
+            {
+                send_one(next_due_);
+                next_due_ += interval_;
+            }
+            if (next_due_ >= stop_at_)
+            {
+                sending_done_ = true;
+                if (outstanding_.empty())
+                    close();
+                return;
+            }
+            timer_.expires_at(next_due_);
+            timer_.async_wait([this](boost::system::error_code ec) {
+                if (!ec)
+                    send_due();
+            });
+        }
+
+        void send_one(Clock::time_point due)
+        {
+            Command command = live_.empty() ? Command::add : static_cast<Command>(command_dist_(gen_));
+            std::string message;
+            OrderID id = 0;
+            switch (command)
+            {
+            case Command::add:
+                id = ++next_id_;
+                build_add(message, id);
+                break;
+            case Command::cancel:
+            {
+                LiveOrder order = live_[std::uniform_int_distribution<std::size_t>(0, live_.size() - 1)(gen_)];
+                remove_live(order.id);
+                id = order.id;
+                build_cancel(message, order);
+                break;
+            }
+            case Command::modify:
+            {
+                const LiveOrder &order = live_[std::uniform_int_distribution<std::size_t>(0, live_.size() - 1)(gen_)];
+                id = order.id;
+                build_modify(message, order);
+                break;
+            }
+            }
+
+            outstanding_[id].push_back({due, command});
+            ++results_.sent;
+            outbox_.push_back(std::move(message));
+            if (outbox_.size() == 1)
+                do_write();
+        }
+
+        // Prices straddle 100 so that a share of the orders cross and trade.
+        Price pick_price(OrderSide side)
+        {
+            int offset = std::uniform_int_distribution<int>(-2, 8)(gen_);
+            return side == OrderSide::buy ? 100 - offset : 100 + offset;
+        }
+
+        Quantity pick_quantity()
+        {
+            return static_cast<Quantity>(std::uniform_int_distribution<int>(1, 10)(gen_));
+        }
+
+        void build_add(std::string &message, OrderID id)
+        {
+            static constexpr std::array<OrderType, 3> order_types = {
+                OrderType::good_till_cancel, OrderType::immediate_or_cancel, OrderType::fill_or_kill};
+            static constexpr std::array<const char *, 3> type_names = {"GTC", "IOC", "FOK"};
+
+            std::size_t type = type_dist_(gen_);
+            std::size_t symbol = pick_symbol();
+            OrderSide side = gen_() % 2 ? OrderSide::buy : OrderSide::sell;
+            Price price = pick_price(side);
+            Quantity quantity = pick_quantity();
+            // Only resting orders can be canceled or modified later.
+            if (order_types[type] == OrderType::good_till_cancel)
+            {
+                live_index_[id] = live_.size();
+                live_.push_back({id, symbol});
+            }
+
+            if (options_.binary)
+            {
+                encode_new_order(message, symbols_[symbol], id, order_types[type], side, price, quantity);
+                return;
+            }
+            json::object order;
+            order["symbol"] = std::string(symbols_[symbol].view());
+            order["id"] = std::to_string(id);
+            order["type"] = type_names[type];
+            order["side"] = side == OrderSide::buy ? "buy" : "sell";
+            order["price"] = price;
+            order["quantity"] = quantity;
+            message = json::serialize(order);
+        }
+
+        void build_cancel(std::string &message, const LiveOrder &order)
+        {
+            if (options_.binary)
+            {
+                encode_cancel(message, symbols_[order.symbol], order.id);
+                return;
+            }
+            json::object cancel;
+            cancel["command"] = "cancel";
+            cancel["symbol"] = std::string(symbols_[order.symbol].view());
+            cancel["id"] = std::to_string(order.id);
+            message = json::serialize(cancel);
+        }
+
+        void build_modify(std::string &message, const LiveOrder &order)
+        {
+            // The side is unknown here; either half of the price range will do.
+            Price price = pick_price(gen_() % 2 ? OrderSide::buy : OrderSide::sell);
+            Quantity quantity = pick_quantity();
+            if (options_.binary)
+            {
+                encode_modify(message, symbols_[order.symbol], order.id, price, quantity);
+                return;
+            }
+            json::object modify;
+            modify["command"] = "modify";
+            modify["symbol"] = std::string(symbols_[order.symbol].view());
+            modify["id"] = std::to_string(order.id);
+            modify["price"] = price;
+            modify["quantity"] = quantity;
+            message = json::serialize(modify);
+        }
+
+        void remove_live(OrderID id)
+        {
+            auto it = live_index_.find(id);
+            if (it == live_index_.end())
+                return;
+            std::size_t slot = it->second;
+            live_index_.erase(it);
+            if (slot + 1 != live_.size())
+            {
+                live_[slot] = live_.back();
+                live_index_[live_[slot].id] = slot;
+            }
+            live_.pop_back();
+        }
+
+        std::size_t pick_symbol()
+        {
+            return symbols_.size() == 1 ? 0 : std::uniform_int_distribution<std::size_t>(0, symbols_.size() - 1)(gen_);
+        }
+
+        void do_write()
+        {
+            ws_.async_write(net::buffer(outbox_.front()), [this](boost::system::error_code ec, std::size_t) {
+                if (ec)
+                {
+                    if (!closed_)
+                        fail("Write", ec);
+                    return;
+                }
+                outbox_.pop_front();
+                if (!outbox_.empty())
+                    do_write();
+            });
+        }
+
+        void do_read()
+        {
+            ws_.async_read(buffer_, [this](boost::system::error_code ec, std::size_t) {
+                if (ec)
+                {
+                    if (!closed_)
+                        fail("Read", ec);
+                    return;
+                }
+                on_reply(Clock::now());
+                buffer_.consume(buffer_.size());
+                if (sending_done_ && outstanding_.empty())
+                    close();
+                else
+                    do_read();
+            });
+        }
+
+        void on_reply(Clock::time_point now)
+        {
+            auto frame = buffer_.data();
+            OrderID id = 0;
+            bool ok = true;
+            bool filled = false; // add replies only
+            if (options_.binary)
+            {
+                BinaryResponse response =
+                    decode_binary_response(static_cast<const unsigned char *>(frame.data()), frame.size());
+                if (response.type != BinaryMessage::execution_report && response.type != BinaryMessage::reject)
+                    return;
+                id = response.id;
+                ok = response.type == BinaryMessage::execution_report;
+                filled = ok && response.status == OrderStatus::filled;
+            }
+            else
+            {
+                json::object reply =
+                    json::parse(std::string_view(static_cast<const char *>(frame.data()), frame.size())).as_object();
+                ok = !reply.contains("error");
+                if (!ok)
+                {
+                    if (const json::value *error_id = reply.if_contains("id"))
+                        id = std::stoull(std::string(std::string_view(error_id->as_string())));
+                }
+                else if (const json::value *message = reply.if_contains("message"))
+                {
+                    // "Order received: 42", "Order canceled: 42", ...
+                    std::string_view text = message->as_string();
+                    std::size_t colon = text.rfind(": ");
+                    if (colon != std::string_view::npos)
+                        id = std::stoull(std::string(text.substr(colon + 2)));
+                    if (const json::value *status = reply.if_contains("status"))
+                        filled = status->as_string() == "filled";
+                }
+            }
+
+            // Requests for one id go to one shard, which answers them in order.
+            auto it = outstanding_.find(id);
+            if (it == outstanding_.end())
+            {
+                ++results_.unmatched;
+                return;
+            }
+            Outstanding request = it->second.front();
+            it->second.pop_front();
+            if (it->second.empty())
+                outstanding_.erase(it);
+
+            ++results_.received;
+            results_.last_reply = now;
+            // A filled add, or a modify of an order that is gone, leaves nothing to cancel or modify.
+            if ((request.command == Command::add && filled) || (request.command == Command::modify && !ok))
+                remove_live(id);
+            if (!ok)
+            {
+                ++results_.rejected;
+                ++results_.rejected_by_command[static_cast<std::size_t>(request.command)];
+                return;
+            }
+            if (request.due >= measure_from_)
+                results_.latency[static_cast<std::size_t>(request.command)].record(
+                    static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - request.due).count()));
+        }
+
+        void close()
+        {
+            if (closed_)
+                return;
+            closed_ = true;
+            timer_.cancel();
+            if (!open_)
+                return;
+            ws_.async_close(websocket::close_code::normal, [](boost::system::error_code) {});
+        }
+
+        const Options &options_;
+        const std::vector<Symbol> &symbols_;
+        websocket::stream<tcp::socket> ws_;
+        net::steady_timer timer_;
+        beast::flat_buffer buffer_;
+        std::deque<std::string> outbox_;
+        std::unordered_map<OrderID, std::deque<Outstanding>> outstanding_;
+        std::vector<LiveOrder> live_;
+        std::unordered_map<OrderID, std::size_t> live_index_; // id -> slot in live_
+        Results &results_;
+
+        OrderID next_id_;
+        std::mt19937_64 gen_;
+        std::discrete_distribution<int> command_dist_;
+        std::discrete_distribution<std::size_t> type_dist_;
+
+        Clock::duration interval_{};
+        Clock::time_point next_due_;
+        Clock::time_point measure_from_;
+        Clock::time_point stop_at_;
+        bool open_ = false;
+        bool sending_done_ = false;
+        bool closed_ = false;
+    };
+
+    // One io_context and its share of the connections.
+    struct Worker
+    {
+        net::io_context ioc;
+        net::steady_timer watchdog{ioc};
+        std::vector<std::unique_ptr<Connection>> connections;
+        Results results;
+
+        // Ends the run once every connection has closed, or abandons the
+        // stragglers at `give_up`.
+        void watch(Clock::time_point give_up)
+        {
+            bool done = std::all_of(connections.begin(), connections.end(),
+                                    [](const auto &connection) { return connection->closed(); });
+            if (done)
+                return;
+            if (Clock::now() >= give_up)
+            {
+                for (auto &connection : connections)
+                    connection->stop();
+                return;
+            }
+            watchdog.expires_after(std::chrono::milliseconds(100));
+            watchdog.async_wait([this, give_up](boost::system::error_code ec) {
+                if (!ec)
+                    watch(give_up);
+            });
+        }
+    };
+
+    void print_latency(const char *command, const LatencyHistogram &histogram)
+    {
+        auto us = [](std::uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+        std::cout << "latency command=" << command
+                  << " count=" << histogram.count()
+                  << " mean_us=" << us(static_cast<std::uint64_t>(histogram.mean()))
+                  << " p50_us=" << us(histogram.percentile(50))
+                  << " p90_us=" << us(histogram.percentile(90))
+                  << " p99_us=" << us(histogram.percentile(99))
+                  << " p99.9_us=" << us(histogram.percentile(99.9))
+                  << " p99.99_us=" << us(histogram.percentile(99.99))
+                  << " max_us=" << us(histogram.max()) << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--host" && has_value)
+                options.host = argv[++i];
+            else if (arg == "--port" && has_value)
+                options.port = argv[++i];
+            else if (arg == "--connections" && has_value)
+                options.connections = std::max<std::size_t>(1, std::stoul(argv[++i]));
+            else if (arg == "--rate" && has_value)
+                options.rate = std::stod(argv[++i]);
+            else if (arg == "--duration" && has_value)
+                options.duration = std::stod(argv[++i]);
+            else if (arg == "--warmup" && has_value)
+                options.warmup = std::stod(argv[++i]);
+            else if (arg == "--threads" && has_value)
+                options.threads = std::max<std::size_t>(1, std::stoul(argv[++i]));
+            else if (arg == "--binary")
+                options.binary = true;
+            else if (arg == "--mix" && has_value)
+                options.mix = parse_ratio(argv[++i]);
+            else if (arg == "--types" && has_value)
+                options.types = parse_ratio(argv[++i]);
+            else if (arg == "--symbols" && has_value)
+                options.symbols = std::max<std::size_t>(1, std::stoul(argv[++i]));
+            else if (arg == "--seed" && has_value)
+                options.seed = std::stoull(argv[++i]);
+            else
+            {
+                std::cerr << "Usage: loadgen [--host H] [--port P] [--connections C] [--rate R] [--duration S]"
+                             " [--warmup S] [--threads T] [--binary] [--mix ADD:CANCEL:MODIFY]"
+                             " [--types GTC:IOC:FOK] [--symbols N] [--seed N]\n";
+                return EXIT_FAILURE;
+            }
+        }
+        if (options.rate <= 0 || options.duration <= 0)
+            throw std::invalid_argument("Rate and duration must be positive");
+        options.warmup = std::clamp(options.warmup, 0.0, options.duration);
+        options.threads = std::min(options.threads, options.connections);
+
+        std::vector<Symbol> symbols;
+        if (options.symbols == 1)
+            symbols.push_back(default_symbol);
+        for (std::size_t i = 0; symbols.size() < options.symbols; ++i)
+            symbols.push_back(Symbol("LOAD" + std::to_string(i)));
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (std::size_t i = 0; i < options.threads; ++i)
+            workers.push_back(std::make_unique<Worker>());
+
+        tcp::resolver resolver(workers.front()->ioc);
+        auto endpoints = resolver.resolve(options.host, options.port);
+
+        // Leave time for every connection to open before the first request is due.
+        Clock::time_point start = Clock::now() + std::chrono::milliseconds(200);
+        for (std::size_t i = 0; i < options.connections; ++i)
+        {
+            Worker &worker = *workers[i % workers.size()];
+            worker.connections.push_back(
+                std::make_unique<Connection>(worker.ioc, options, symbols, i, start, worker.results));
+            worker.connections.back()->run(endpoints);
+        }
+
+        Clock::time_point give_up = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.duration + options.drain));
+        std::vector<std::thread> threads;
+        for (auto &worker : workers)
+        {
+            threads.emplace_back([&worker, give_up] {
+                worker->watch(give_up);
+                worker->ioc.run();
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        Results results;
+        for (const auto &worker : workers)
+            results.merge(worker->results);
+        LatencyHistogram all;
+        for (const LatencyHistogram &histogram : results.latency)
+            all.merge(histogram);
+
+        double seconds = results.last_reply > start ? std::chrono::duration<double>(results.last_reply - start).count() : 0;
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "connections=" << options.connections
+                  << " threads=" << options.threads
+                  << " protocol=" << (options.binary ? "binary" : "json")
+                  << " rate=" << options.rate
+                  << " duration=" << options.duration
+                  << " warmup=" << options.warmup
+                  << " mix=" << options.mix[0] << ":" << options.mix[1] << ":" << options.mix[2]
+                  << " types=" << options.types[0] << ":" << options.types[1] << ":" << options.types[2]
+                  << " symbols=" << options.symbols << "\n";
+        std::cout << "sent=" << results.sent
+                  << " received=" << results.received
+                  << " rejected=" << results.rejected
+                  << " rejected_add=" << results.rejected_by_command[0]
+                  << " rejected_cancel=" << results.rejected_by_command[1]
+                  << " rejected_modify=" << results.rejected_by_command[2]
+                  << " unmatched=" << results.unmatched
+                  << " lost=" << results.lost
+                  << " failed_connections=" << results.failed_connections
+                  << " offered_per_sec=" << results.sent / options.duration
+                  << " achieved_per_sec=" << (seconds > 0 ? results.received / seconds : 0.0) << "\n";
+        for (std::size_t i = 0; i < results.latency.size(); ++i)
+            print_latency(command_names[i], results.latency[i]);
+        print_latency("all", all);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Load generator error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
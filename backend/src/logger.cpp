@@ -0,0 +1,86 @@
+#include "logger.hpp"
+#include <chrono>
+
+std::string format_log_record(const LogRecord &record)
+{
+    const auto &args = record.args;
+    switch (record.event)
+    {
+    case LogEvent::order_added:
+        return "Added order " + std::to_string(args[0]);
+    case LogEvent::order_canceled:
+        return "Canceled order " + std::to_string(args[0]);
+    case LogEvent::order_modified:
+        return "Modified order " + std::to_string(args[0]) +
+               " to new price " + std::to_string(args[1]) +
+               " and new total quantity " + std::to_string(args[2]);
+    case LogEvent::filled_by_modify:
+        return "Order " + std::to_string(args[0]) + " fully filled after modification.";
+    case LogEvent::insufficient_liquidity:
+        return "Insufficient liquidity for fill_or_kill order " + std::to_string(args[0]);
+    case LogEvent::remainder_canceled:
+        return "ImmediateOrCancel order " + std::to_string(args[0]) + " canceled due to remaining quantity";
+    case LogEvent::trade:
+        return "Trade executed between orders " + std::to_string(args[0]) + " and " +
+               std::to_string(args[1]) + " at price " + std::to_string(args[2]);
+    case LogEvent::iceberg_replenished:
+        return "Iceberg order " + std::to_string(args[0]) + " replenished with visible quantity " +
+               std::to_string(args[1]);
+    case LogEvent::stop_triggered:
+        return "Stop order " + std::to_string(args[0]) + " triggered at stop price " + std::to_string(args[1]);
+    }
+    return "Unknown log event";
+}
+
+AsyncLogger::AsyncLogger(std::ostream &out, LogLevel level, std::size_t capacity)
+    : Logger(level), out_(out), queue_(capacity), writer_([this] { run(); }) {}
+
+AsyncLogger::~AsyncLogger()
+{
+    running_.store(false, std::memory_order_release);
+    writer_.join();
+}
+
+void AsyncLogger::log(const std::string &msg)
+{
+    std::string line = "[LOG] " + msg + '\n';
+    std::lock_guard<std::mutex> lock(out_mutex_);
+    out_ << line;
+    out_.flush();
+}
+
+void AsyncLogger::record(const LogRecord &record)
+{
+    if (!queue_.try_push(record))
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncLogger::run()
+{
+    while (running_.load(std::memory_order_acquire))
+    {
+        if (!drain())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    drain();
+}
+
+// Formats everything queued so far; returns false if there was nothing to do.
+bool AsyncLogger::drain()
+{
+    LogRecord record;
+    if (!queue_.try_pop(record))
+        return false;
+
+    std::string lines;
+    do
+    {
+        lines += "[LOG] " + format_log_record(record) + '\n';
+    } while (queue_.try_pop(record));
+
+    // One write per batch keeps lines whole when several loggers share a stream.
+    std::lock_guard<std::mutex> lock(out_mutex_);
+    out_ << lines;
+    out_.flush();
+    return true;
+}
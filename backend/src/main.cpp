@@ -2,16 +2,14 @@
 #include "logger.hpp"
 #include <iostream>
 
-void print_trade_history(const Trades &trades)
+void print_trade_history(const TradeTape &trades)
 {
     for (const auto &trade : trades)
     {
-        const auto &bid_trade = trade.get_bid_trade();
-        const auto &ask_trade = trade.get_ask_trade();
-        std::cout << "Trade: Bid Order " << bid_trade.order_id
-                  << " and Ask Order " << ask_trade.order_id
-                  << " at Price " << bid_trade.price
-                  << " for Quantity " << bid_trade.quantity << "\n";
+        std::cout << "Trade: Bid Order " << trade.get_bid_order_id()
+                  << " and Ask Order " << trade.get_ask_order_id()
+                  << " at Price " << trade.get_price()
+                  << " for Quantity " << trade.get_quantity() << "\n";
     }
 }
 
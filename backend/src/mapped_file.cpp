@@ -0,0 +1,40 @@
+#include "mapped_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+
+    struct stat info;
+    void *mapping = nullptr;
+    if (::fstat(fd, &info) == 0)
+    {
+        size_ = static_cast<std::size_t>(info.st_size);
+        mapping = size_ == 0 ? nullptr : ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    else
+        mapping = MAP_FAILED;
+    int error = errno;
+    // The mapping keeps the file referenced on its own.
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("Cannot map " + path + ": " + std::strerror(error));
+
+    data_ = static_cast<const unsigned char *>(mapping);
+    if (data_)
+        ::madvise(mapping, size_, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_)
+        ::munmap(const_cast<unsigned char *>(data_), size_);
+}
@@ -0,0 +1,174 @@
+#include "market_analytics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::uint64_t nanoseconds_per_second = 1000000000;
+}
+
+MarketAnalytics::MarketAnalytics(const AnalyticsConfig &config)
+    : depth_(std::max<std::size_t>(config.depth, 1)), windows_(config.windows)
+{
+    std::uint32_t longest = 0;
+    for (std::uint32_t window : windows_)
+    {
+        if (window == 0)
+            throw std::invalid_argument("Analytics windows must be at least one second");
+        longest = std::max(longest, window);
+    }
+    buckets_.resize(longest);
+    bids_.levels.reserve(depth_ + 1);
+    asks_.levels.reserve(depth_ + 1);
+}
+
+void MarketAnalytics::on_level(OrderSide side, const OrderLevel &level)
+{
+    Side &book_side = side_of(side);
+    OrderLevels &levels = book_side.levels;
+    bool buy = side == OrderSide::buy;
+    // First kept level that is not better than the changed one.
+    auto it = std::find_if(levels.begin(), levels.end(), [&](const OrderLevel &kept) {
+        return buy ? kept.price <= level.price : kept.price >= level.price;
+    });
+    bool present = it != levels.end() && it->price == level.price;
+
+    if (level.quantity == 0)
+    {
+        if (!present)
+            return;
+        book_side.quantity -= it->quantity;
+        levels.erase(it);
+        // The level below the kept range, if any, has moved into it.
+        book_side.stale = true;
+        return;
+    }
+    if (present)
+    {
+        book_side.quantity = book_side.quantity - it->quantity + level.quantity;
+        *it = level;
+        return;
+    }
+    if (it == levels.end() && levels.size() >= depth_)
+        return;
+
+    levels.insert(it, level);
+    book_side.quantity += level.quantity;
+    if (levels.size() > depth_)
+    {
+        book_side.quantity -= levels.back().quantity;
+        levels.pop_back();
+    }
+}
+
+bool MarketAnalytics::needs_refill(OrderSide side) const
+{
+    return side_of(side).stale;
+}
+
+void MarketAnalytics::refill(OrderSide side, const OrderLevels &levels)
+{
+    Side &book_side = side_of(side);
+    book_side.levels.assign(levels.begin(), levels.begin() + std::min(levels.size(), depth_));
+    book_side.quantity = 0;
+    for (const OrderLevel &level : book_side.levels)
+        book_side.quantity += level.quantity;
+    book_side.stale = false;
+}
+
+void MarketAnalytics::on_trade(const Trade &trade, std::uint64_t now_ns)
+{
+    Price price = trade.get_price();
+    Quantity quantity = trade.get_quantity();
+    double squared_return = 0;
+    if (last_price_ > 0 && price > 0)
+    {
+        double log_return = std::log(static_cast<double>(price) / static_cast<double>(last_price_));
+        squared_return = log_return * log_return;
+    }
+    last_price_ = price;
+    ++trades_;
+    volume_ += quantity;
+
+    if (buckets_.empty())
+        return;
+    std::uint64_t second = now_ns / nanoseconds_per_second;
+    Bucket &bucket = buckets_[second % buckets_.size()];
+    if (bucket.second != second)
+        bucket = Bucket{second};
+    ++bucket.trades;
+    bucket.volume += quantity;
+    bucket.notional += static_cast<double>(price) * quantity;
+    bucket.squared_returns += squared_return;
+}
+
+AnalyticsSnapshot MarketAnalytics::snapshot(std::uint64_t now_ns) const
+{
+    AnalyticsSnapshot snapshot;
+    snapshot.has_bid = !bids_.levels.empty();
+    snapshot.has_ask = !asks_.levels.empty();
+    if (snapshot.has_bid)
+        snapshot.best_bid = bids_.levels.front();
+    if (snapshot.has_ask)
+        snapshot.best_ask = asks_.levels.front();
+    if (snapshot.has_bid && snapshot.has_ask)
+    {
+        const OrderLevel &bid = snapshot.best_bid;
+        const OrderLevel &ask = snapshot.best_ask;
+        snapshot.spread = ask.price - bid.price;
+        snapshot.mid = (static_cast<double>(bid.price) + ask.price) / 2;
+        snapshot.microprice = (static_cast<double>(bid.price) * ask.quantity +
+                               static_cast<double>(ask.price) * bid.quantity) /
+                              (static_cast<double>(bid.quantity) + ask.quantity);
+    }
+    snapshot.depth = depth_;
+    snapshot.bid_depth_quantity = bids_.quantity;
+    snapshot.ask_depth_quantity = asks_.quantity;
+    std::uint64_t resting = bids_.quantity + asks_.quantity;
+    if (resting != 0)
+        snapshot.imbalance = (static_cast<double>(bids_.quantity) - static_cast<double>(asks_.quantity)) /
+                             static_cast<double>(resting);
+    snapshot.last_price = last_price_;
+    snapshot.trades = trades_;
+    snapshot.volume = volume_;
+
+    struct Totals
+    {
+        std::uint64_t trades = 0;
+        std::uint64_t volume = 0;
+        double notional = 0;
+        double squared_returns = 0;
+    };
+    std::vector<Totals> totals(windows_.size());
+    std::uint64_t now_second = now_ns / nanoseconds_per_second;
+    for (const Bucket &bucket : buckets_)
+    {
+        if (bucket.second == empty_bucket || bucket.second > now_second)
+            continue;
+        std::uint64_t age = now_second - bucket.second;
+        for (std::size_t i = 0; i < windows_.size(); ++i)
+        {
+            if (age >= windows_[i])
+                continue;
+            totals[i].trades += bucket.trades;
+            totals[i].volume += bucket.volume;
+            totals[i].notional += bucket.notional;
+            totals[i].squared_returns += bucket.squared_returns;
+        }
+    }
+
+    snapshot.windows.reserve(windows_.size());
+    for (std::size_t i = 0; i < windows_.size(); ++i)
+    {
+        WindowAnalytics window;
+        window.seconds = windows_[i];
+        window.trades = totals[i].trades;
+        window.volume = totals[i].volume;
+        if (window.volume != 0)
+            window.vwap = totals[i].notional / static_cast<double>(window.volume);
+        window.volatility = std::sqrt(totals[i].squared_returns);
+        snapshot.windows.push_back(window);
+    }
+    return snapshot;
+}
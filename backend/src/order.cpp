@@ -1,9 +1,11 @@
 #include "order.hpp"
+#include <algorithm>
+#include <limits>
 
 Order::Order(OrderID id, OrderType type, OrderSide side, Price price, Quantity initial_quantity)
-    : id_(id), type_(type), side_(side), price_(price),
+    : id_(id), type_(type), side_(side), status_(OrderStatus::open), price_(price),
       initial_quantity_(initial_quantity), remaining_quantity_(initial_quantity),
-      timestamp_(std::chrono::steady_clock::now()), status_(OrderStatus::open) {}
+      timestamp_(std::chrono::steady_clock::now()) {}
 
 OrderID Order::get_id() const { return id_; }
 OrderType Order::get_type() const { return type_; }
@@ -15,6 +17,19 @@ Quantity Order::get_filled_quantity() const { return initial_quantity_ - remaini
 OrderStatus Order::get_status() const { return status_; }
 auto Order::get_timestamp() const { return timestamp_; }
 
+Price Order::get_stop_price() const { return stop_price_; }
+Quantity Order::get_display_quantity() const { return display_quantity_; }
+Quantity Order::get_visible_quantity() const { return is_iceberg() ? visible_quantity_ : remaining_quantity_; }
+Quantity Order::get_hidden_quantity() const { return remaining_quantity_ - get_visible_quantity(); }
+
+void Order::set_stop_price(Price stop_price) { stop_price_ = stop_price; }
+
+void Order::set_display_quantity(Quantity display_quantity)
+{
+    display_quantity_ = display_quantity;
+    visible_quantity_ = std::min(display_quantity_, remaining_quantity_);
+}
+
 void Order::cancel()
 {
     if (status_ == OrderStatus::filled)
@@ -50,3 +65,27 @@ void Order::fill(Quantity quantity)
     remaining_quantity_ -= quantity;
     status_ = (remaining_quantity_ == 0) ? OrderStatus::filled : OrderStatus::partially_filled;
 }
+
+void Order::consume_visible(Quantity quantity)
+{
+    visible_quantity_ -= std::min(quantity, visible_quantity_);
+}
+
+void Order::replenish()
+{
+    visible_quantity_ = std::min(display_quantity_, remaining_quantity_);
+    timestamp_ = std::chrono::steady_clock::now();
+}
+
+void Order::trigger()
+{
+    if (type_ == OrderType::stop)
+    {
+        type_ = OrderType::immediate_or_cancel;
+        price_ = side_ == OrderSide::buy ? std::numeric_limits<Price>::max() : std::numeric_limits<Price>::min();
+    }
+    else if (type_ == OrderType::stop_limit)
+    {
+        type_ = OrderType::good_till_cancel;
+    }
+}
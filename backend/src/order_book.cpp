@@ -1,60 +1,242 @@
 #include "order_book.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
 
-OrderBook::OrderBook(Logger *logger) : logger_(logger ? *logger : get_default_logger()) {}
+namespace
+{
+    template <typename Levels>
+    OrderLevels collect_levels(const Levels &levels, std::size_t depth)
+    {
+        OrderLevels result;
+        result.reserve(std::min(depth, levels.size()));
+        for (const auto& [price, level] : levels) {
+            if (result.size() == depth)
+                break;
+            result.push_back({price, level.total_quantity, level.order_count});
+        }
+        return result;
+    }
+
+    template <typename Levels>
+    OrderLevel current_level(const Levels &levels, Price price)
+    {
+        auto level_it = levels.find(price);
+        if (level_it == levels.end())
+            return {price, 0, 0};
+        return {price, level_it->second.total_quantity, level_it->second.order_count};
+    }
 
-const Trades &OrderBook::get_trade_history() const { return trade_history_; }
+    RestingOrder resting_order(const Order *order)
+    {
+        RestingOrder resting{order->get_id(), order->get_type(), order->get_side(), order->get_price(),
+                             order->get_initial_quantity(), order->get_remaining_quantity()};
+        if (order->is_stop())
+            resting.stop_price = order->get_stop_price();
+        if (order->is_iceberg())
+        {
+            resting.display_quantity = order->get_display_quantity();
+            resting.visible_quantity = order->get_visible_quantity();
+        }
+        return resting;
+    }
 
-OrderLevels OrderBook::get_bids() const {
-    OrderLevels levels;
-    for (const auto& [price, orders] : bids_) {
-        if (!orders.empty()) {
-            Quantity total = 0;
-            for (const auto& order : orders) {
-                total += order->get_remaining_quantity();
-            }
-            levels.push_back({price, total});
+    template <typename Levels>
+    void collect_orders(const Levels &levels, std::vector<RestingOrder> &orders)
+    {
+        for (const auto &[price, level] : levels)
+        {
+            for (const Order *order : level.orders)
+                orders.push_back(resting_order(order));
         }
     }
-    return levels;
+
+    template <typename Levels>
+    void remove_from_level(Levels &levels, OrderPointer order)
+    {
+        auto level_it = levels.find(order->get_price());
+        if (level_it == levels.end())
+            return;
+
+        auto &level = level_it->second;
+        level.erase(order);
+        if (level.empty())
+            levels.erase(level_it);
+    }
+
+    // Takes `quantity` off a resting order's level aggregate, leaving its queue alone.
+    template <typename Levels>
+    void reduce_in_level(Levels &levels, OrderPointer order, Quantity quantity)
+    {
+        auto level_it = levels.find(order->get_price());
+        if (level_it != levels.end())
+            level_it->second.reduce(quantity);
+    }
+}
+
+OrderBook::OrderBook(Logger *logger, const BookConfig &config)
+    : sides_(make_sides(config)), trade_tape_(config.trade_capacity),
+      logger_(logger ? *logger : get_default_logger()), matching_engine_(*this, logger_)
+{
+    order_pool_.reserve(config.order_capacity);
+    order_lookup_.reserve(config.order_capacity);
+}
+
+std::variant<OrderBook::TreeSides, OrderBook::LadderSides> OrderBook::make_sides(const BookConfig &config)
+{
+    if (config.layout == BookLayout::ladder)
+    {
+        return LadderSides{{config.center_price, config.tick_size, config.ladder_levels, config.ladder_max_levels},
+                           {config.center_price, config.tick_size, config.ladder_levels, config.ladder_max_levels}};
+    }
+    return TreeSides{};
 }
 
-OrderLevels OrderBook::get_asks() const {
-    OrderLevels levels;
-    for (const auto& [price, orders] : asks_) {
-        if (!orders.empty()) {
-            Quantity total = 0;
-            for (const auto& order : orders) {
-                total += order->get_remaining_quantity();
-            }
-            levels.push_back({price, total});
+const TradeTape &OrderBook::get_trade_history() const { return trade_tape_; }
+
+OrderLevels OrderBook::get_bids(std::size_t depth) const {
+    return std::visit([depth](const auto &sides) { return collect_levels(sides.bids, depth); }, sides_);
+}
+
+OrderLevels OrderBook::get_asks(std::size_t depth) const {
+    return std::visit([depth](const auto &sides) { return collect_levels(sides.asks, depth); }, sides_);
+}
+
+OrderPoolStats OrderBook::get_pool_stats() const { return order_pool_.get_stats(); }
+
+void OrderBook::set_level_tracking(bool enabled)
+{
+    level_tracking_ = enabled;
+    changed_levels_.clear();
+}
+
+void OrderBook::take_level_changes(OrderLevels &bids, OrderLevels &asks)
+{
+    // Buys sort before sells; within a side, best price first.
+    std::sort(changed_levels_.begin(), changed_levels_.end(), [](const auto &a, const auto &b) {
+        if (a.first != b.first)
+            return a.first == OrderSide::buy;
+        return a.first == OrderSide::buy ? a.second > b.second : a.second < b.second;
+    });
+    changed_levels_.erase(std::unique(changed_levels_.begin(), changed_levels_.end()), changed_levels_.end());
+
+    std::visit([&](const auto &sides) {
+        for (const auto &[side, price] : changed_levels_)
+        {
+            if (side == OrderSide::buy)
+                bids.push_back(current_level(sides.bids, price));
+            else
+                asks.push_back(current_level(sides.asks, price));
         }
+    }, sides_);
+    changed_levels_.clear();
+}
+
+std::vector<RestingOrder> OrderBook::get_resting_orders() const
+{
+    std::vector<RestingOrder> orders;
+    orders.reserve(order_lookup_.size());
+    std::visit([&orders](const auto &sides) {
+        collect_orders(sides.bids, orders);
+        collect_orders(sides.asks, orders);
+    }, sides_);
+    stop_book_.for_each([&orders](const Order *order) { orders.push_back(resting_order(order)); });
+    return orders;
+}
+
+void OrderBook::restore_orders(const std::vector<RestingOrder> &orders)
+{
+    if (!order_lookup_.empty())
+        throw std::runtime_error("Orders can only be restored into an empty book");
+    order_pool_.reserve(orders.size());
+    order_lookup_.reserve(orders.size());
+    std::visit([&](auto &sides) { restore_levels(sides, orders); }, sides_);
+}
+
+template <typename BookSides>
+void OrderBook::restore_levels(BookSides &sides, const std::vector<RestingOrder> &orders)
+{
+    PriceLevel *level = nullptr;
+    for (std::size_t i = 0; i < orders.size(); ++i)
+    {
+        const RestingOrder &resting = orders[i];
+        if (resting.remaining_quantity == 0 || resting.remaining_quantity > resting.initial_quantity)
+            throw std::runtime_error("Invalid resting order quantity");
+        if (order_lookup_.contains(resting.id))
+            throw std::runtime_error("Duplicate order id");
+        bool iceberg = resting.type == OrderType::iceberg;
+        if (iceberg && (resting.display_quantity == 0 || resting.visible_quantity == 0 ||
+                        resting.visible_quantity > std::min(resting.display_quantity, resting.remaining_quantity)))
+            throw std::runtime_error("Invalid iceberg display quantity");
+
+        OrderPointer order = order_pool_.acquire(resting.id, resting.type, resting.side, resting.price,
+                                                 resting.initial_quantity);
+        if (resting.remaining_quantity < resting.initial_quantity)
+            order->fill(resting.initial_quantity - resting.remaining_quantity);
+        order_lookup_.insert(resting.id, order);
+
+        if (order->is_stop())
+        {
+            order->set_stop_price(resting.stop_price);
+            stop_book_.push_back(order);
+            level = nullptr;
+            continue;
+        }
+        if (iceberg)
+        {
+            order->set_display_quantity(resting.display_quantity);
+            order->consume_visible(order->get_visible_quantity() - resting.visible_quantity);
+        }
+
+        // Only the first order of each level pays for the level lookup.
+        if (level == nullptr || resting.side != orders[i - 1].side || resting.price != orders[i - 1].price)
+        {
+            level = resting.side == OrderSide::buy ? &sides.bids[resting.price] : &sides.asks[resting.price];
+            on_level_changed(resting.side, resting.price);
+        }
+        level->push_back(order);
     }
-    return levels;
 }
 
-OrderPointer OrderBook::add_order(OrderID id, OrderType type, OrderSide side, Price price, Quantity quantity)
+OrderStatus OrderBook::add_order(OrderID id, OrderType type, OrderSide side, Price price, Quantity quantity,
+                                 Price stop_price, Quantity display_quantity)
 {
-    OrderPointer order = std::make_shared<Order>(id, type, side, price, quantity);
-    order_lookup_[id] = order;
-    logger_.log("Added order " + std::to_string(id));
+    if (type == OrderType::iceberg && (display_quantity == 0 || display_quantity > quantity))
+        throw std::runtime_error("Display quantity must be between 1 and the order quantity");
+    // Checked before anything trades, so an order that could not rest never starts matching.
+    if (type != OrderType::immediate_or_cancel && type != OrderType::fill_or_kill && type != OrderType::stop &&
+        !can_rest_at(side, price))
+        throw std::invalid_argument("Price is too far from the book's other levels");
 
-    auto cancel_lambda = [this](OrderID order_id)
-    { this->cancel_order(order_id); };
-    MatchingEngine matching_engine(order_lookup_, trade_history_, cancel_lambda, logger_);
+    OrderPointer order = order_pool_.acquire(id, type, side, price, quantity);
+    if (!order_lookup_.insert(id, order))
+    {
+        order_pool_.release(order);
+        throw std::runtime_error("Duplicate order id");
+    }
+    logger_.event<LogLevel::debug>(LogEvent::order_added, static_cast<std::int64_t>(id));
 
-    if (side == OrderSide::buy)
+    if (order->is_stop())
     {
-        matching_engine.match_order(order, asks_);
-        if (order->get_remaining_quantity() > 0)
-            bids_[price].push_back(order);
+        order->set_stop_price(stop_price);
+        stop_book_.push_back(order);
+        return order->get_status();
     }
-    else
+    if (order->is_iceberg())
+        order->set_display_quantity(display_quantity);
+
+    OrderStatus status = std::visit([&](auto &sides) { return match_and_rest(sides, order); }, sides_);
+    if (stop_book_.empty())
+        return status;
+
+    trigger_stops();
+    // A triggered stop may have traded against the order that just rested.
+    if (status == OrderStatus::open || status == OrderStatus::partially_filled)
     {
-        matching_engine.match_order(order, bids_);
-        if (order->get_remaining_quantity() > 0)
-            asks_[order->get_price()].push_back(order);
+        OrderPointer resting = order_lookup_.find(id);
+        status = resting ? resting->get_status() : OrderStatus::filled;
     }
-    return order;
+    return status;
 }
 
 void OrderBook::cancel_order(OrderID id)
@@ -64,6 +246,7 @@ void OrderBook::cancel_order(OrderID id)
         throw std::runtime_error("Cannot cancel a filled order");
 
     cancel_order_impl(order);
+    order_pool_.release(order);
 }
 
 void OrderBook::modify_order(OrderID id, Price new_price, Quantity new_total_quantity)
@@ -71,6 +254,32 @@ void OrderBook::modify_order(OrderID id, Price new_price, Quantity new_total_qua
     OrderPointer order = find_order(id);
     if (order->get_status() == OrderStatus::filled || order->get_status() == OrderStatus::canceled)
         throw std::runtime_error("Cannot modify a filled or canceled order");
+    if (order->is_stop())
+        throw std::runtime_error("Cannot modify a stop order before it triggers");
+    // Checked before the order leaves its level, so a rejected modify leaves it resting.
+    if (new_total_quantity < order->get_filled_quantity())
+        throw std::runtime_error("Cannot reduce quantity below filled quantity");
+    if (new_price != order->get_price() && !can_rest_at(order->get_side(), new_price))
+        throw std::invalid_argument("Price is too far from the book's other levels");
+
+    // Same price, smaller size, something left: the order cannot become
+    // marketable, so it shrinks in place and keeps its time priority.
+    if (new_price == order->get_price() && new_total_quantity < order->get_initial_quantity() &&
+        new_total_quantity > order->get_filled_quantity() && !order->is_iceberg())
+    {
+        Quantity reduction = order->get_initial_quantity() - new_total_quantity;
+        order->modify(new_price, new_total_quantity);
+        std::visit([&](auto &sides) {
+            if (order->get_side() == OrderSide::buy)
+                reduce_in_level(sides.bids, order, reduction);
+            else
+                reduce_in_level(sides.asks, order, reduction);
+        }, sides_);
+        on_level_changed(order->get_side(), new_price);
+        logger_.event<LogLevel::debug>(LogEvent::order_modified, static_cast<std::int64_t>(id),
+                                       new_price, new_total_quantity);
+        return;
+    }
 
     // Remove order from its current container.
     remove_order_impl(order);
@@ -78,84 +287,148 @@ void OrderBook::modify_order(OrderID id, Price new_price, Quantity new_total_qua
     // Modify the order.
     order->modify(new_price, new_total_quantity);
 
-    logger_.log("Modified order " + std::to_string(id) +
-                " to new price " + std::to_string(new_price) +
-                " and new total quantity " + std::to_string(new_total_quantity));
+    logger_.event<LogLevel::debug>(LogEvent::order_modified, static_cast<std::int64_t>(id),
+                                   new_price, new_total_quantity);
 
     // If modification makes the order fully filled, remove from lookup and log.
     if (order->get_status() == OrderStatus::filled)
     {
         order_lookup_.erase(id);
-        logger_.log("Order " + std::to_string(id) + " fully filled after modification.");
+        order_pool_.release(order);
+        logger_.event<LogLevel::debug>(LogEvent::filled_by_modify, static_cast<std::int64_t>(id));
         return;
     }
 
     // Attempt to re-match the modified order against the opposite book.
-    auto cancel_lambda = [this](OrderID order_id)
-    { this->cancel_order(order_id); };
-    MatchingEngine matching_engine(order_lookup_, trade_history_, cancel_lambda, logger_);
+    std::visit([&](auto &sides) { match_and_rest(sides, order); }, sides_);
+    if (!stop_book_.empty())
+        trigger_stops();
+}
 
+// Matches an incoming order against the opposite side and rests whatever is left.
+// Orders that do not rest are released back to the pool.
+template <typename BookSides>
+OrderStatus OrderBook::match_and_rest(BookSides &sides, OrderPointer order)
+{
     if (order->get_side() == OrderSide::buy)
+        matching_engine_.match_order(order, sides.asks);
+    else
+        matching_engine_.match_order(order, sides.bids);
+
+    // IOC and FOK remainders have been canceled by the engine and must not rest.
+    OrderStatus status = order->get_status();
+    if (order->get_remaining_quantity() == 0 || status == OrderStatus::canceled)
     {
-        matching_engine.match_order(order, asks_);
-        if (order->get_remaining_quantity() > 0)
-            bids_[order->get_price()].push_back(order);
+        order_lookup_.erase(order->get_id());
+        order_pool_.release(order);
+        return status;
     }
-    else
+
+    // Adds and modifies check the price up front; a stop limit is only
+    // checked when it triggers, and the book may have moved far away since.
+    if constexpr (std::is_same_v<BookSides, LadderSides>)
     {
-        matching_engine.match_order(order, bids_);
-        if (order->get_remaining_quantity() > 0)
-            asks_[order->get_price()].push_back(order);
+        if (!can_rest_at(order->get_side(), order->get_price()))
+        {
+            on_order_killed(order);
+            order_pool_.release(order);
+            return OrderStatus::canceled;
+        }
     }
+
+    // An iceberg rests with a fresh slice of whatever is left after matching.
+    if (order->is_iceberg())
+        order->replenish();
+    if (order->get_side() == OrderSide::buy)
+        sides.bids[order->get_price()].push_back(order);
+    else
+        sides.asks[order->get_price()].push_back(order);
+    on_level_changed(order->get_side(), order->get_price());
+    return status;
+}
+
+void OrderBook::on_trade(const Trade &trade)
+{
+    trade_tape_.publish(trade);
+    if (!stop_book_.empty())
+        stop_book_.on_trade(trade.get_price());
+}
+
+void OrderBook::on_resting_filled(OrderPointer order)
+{
+    order_lookup_.erase(order->get_id());
+    order_pool_.release(order);
+}
+
+// The incoming order never rested, so only its status and id entry need clearing;
+// match_and_rest releases the record once the engine returns.
+void OrderBook::on_order_killed(OrderPointer order)
+{
+    order->cancel();
+    order_lookup_.erase(order->get_id());
+    logger_.event<LogLevel::debug>(LogEvent::order_canceled, static_cast<std::int64_t>(order->get_id()));
+}
+
+void OrderBook::on_level_changed(OrderSide side, Price price)
+{
+    ++version_;
+    if (level_tracking_)
+        changed_levels_.emplace_back(side, price);
+}
+
+bool OrderBook::can_rest_at(OrderSide side, Price price) const
+{
+    return std::visit([side, price](const auto &sides) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(sides)>, LadderSides>)
+            return side == OrderSide::buy ? sides.bids.fits(price) : sides.asks.fits(price);
+        else
+            return true;
+    }, sides_);
 }
 
 OrderPointer OrderBook::find_order(OrderID id)
 {
-    auto it = order_lookup_.find(id);
-    if (it == order_lookup_.end())
+    OrderPointer order = order_lookup_.find(id);
+    if (order == nullptr)
         throw std::runtime_error("Order not found (find_order)");
-    return it->second;
+    return order;
 }
 
-// Cancel an order and remove it from the order book
-void OrderBook::cancel_order_impl(OrderPointer order)
+// Triggered stops are matched in the order StopBook returns them; their own
+// trades widen the traded range, so a cascade runs to its end here.
+void OrderBook::trigger_stops()
 {
-    Price price = order->get_price();
-    if (order->get_side() == OrderSide::buy)
+    while (OrderPointer order = stop_book_.pop_triggered())
     {
-        auto &order_list = bids_[price];
-        order_list.erase(std::remove(order_list.begin(), order_list.end(), order), order_list.end());
-        if (order_list.empty())
-            bids_.erase(price);
-    }
-    else
-    {
-        auto &order_list = asks_[price];
-        order_list.erase(std::remove(order_list.begin(), order_list.end(), order), order_list.end());
-        if (order_list.empty())
-            asks_.erase(price);
+        logger_.event<LogLevel::debug>(LogEvent::stop_triggered, static_cast<std::int64_t>(order->get_id()),
+                                       order->get_stop_price());
+        order->trigger();
+        std::visit([&](auto &sides) { match_and_rest(sides, order); }, sides_);
     }
+}
+
+// Cancel an order and remove it from the order book
+void OrderBook::cancel_order_impl(OrderPointer order)
+{
+    remove_order_impl(order);
     order->cancel();
     order_lookup_.erase(order->get_id());
-    logger_.log("Canceled order " + std::to_string(order->get_id()));
+    logger_.event<LogLevel::debug>(LogEvent::order_canceled, static_cast<std::int64_t>(order->get_id()));
 }
 
 // Remove an order without canceling it (for modification)
 void OrderBook::remove_order_impl(OrderPointer order)
 {
-    Price price = order->get_price();
-    if (order->get_side() == OrderSide::buy)
-    {
-        auto &order_list = bids_[price];
-        order_list.erase(std::remove(order_list.begin(), order_list.end(), order), order_list.end());
-        if (order_list.empty())
-            bids_.erase(price);
-    }
-    else
+    if (order->is_stop())
     {
-        auto &order_list = asks_[price];
-        order_list.erase(std::remove(order_list.begin(), order_list.end(), order), order_list.end());
-        if (order_list.empty())
-            asks_.erase(price);
+        stop_book_.erase(order);
+        return;
     }
-}
\ No newline at end of file
+    std::visit([&](auto &sides) {
+        if (order->get_side() == OrderSide::buy)
+            remove_from_level(sides.bids, order);
+        else
+            remove_from_level(sides.asks, order);
+    }, sides_);
+    on_level_changed(order->get_side(), order->get_price());
+}
@@ -0,0 +1,96 @@
+#include "order_index.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    constexpr std::size_t min_slots = 16;
+}
+
+OrderIndex::OrderIndex(std::size_t capacity)
+{
+    rehash(slots_for(capacity));
+}
+
+bool OrderIndex::insert(OrderID id, OrderPointer order)
+{
+    if (order == nullptr)
+        throw std::invalid_argument("OrderIndex cannot hold a null order");
+    if (size_ >= grow_at_)
+        rehash(slots_.size() * 2);
+
+    std::size_t i = home(id);
+    for (; slots_[i].order != nullptr; i = (i + 1) & mask_)
+    {
+        if (slots_[i].id == id)
+            return false;
+    }
+    slots_[i] = {id, order};
+    ++size_;
+    return true;
+}
+
+bool OrderIndex::erase(OrderID id)
+{
+    std::size_t hole = home(id);
+    for (;; hole = (hole + 1) & mask_)
+    {
+        if (slots_[hole].order == nullptr)
+            return false;
+        if (slots_[hole].id == id)
+            break;
+    }
+
+    // Backward-shift deletion: pull each later entry of the run into the hole
+    // unless its home lies cyclically after the hole, where moving it would
+    // put it before the start of its own probe sequence.
+    for (std::size_t next = (hole + 1) & mask_; slots_[next].order != nullptr; next = (next + 1) & mask_)
+    {
+        std::size_t entry_home = home(slots_[next].id);
+        if (((next - entry_home) & mask_) >= ((next - hole) & mask_))
+        {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+    }
+    slots_[hole] = Slot{};
+    --size_;
+    return true;
+}
+
+void OrderIndex::reserve(std::size_t count)
+{
+    std::size_t wanted = slots_for(count);
+    if (wanted > slots_.size())
+        rehash(wanted);
+}
+
+void OrderIndex::clear()
+{
+    std::fill(slots_.begin(), slots_.end(), Slot{});
+    size_ = 0;
+}
+
+std::size_t OrderIndex::slots_for(std::size_t count)
+{
+    // Smallest power of two that holds `count` entries within max_load.
+    return std::bit_ceil(std::max(min_slots, static_cast<std::size_t>(static_cast<double>(count) / max_load) + 1));
+}
+
+void OrderIndex::rehash(std::size_t slot_count)
+{
+    std::vector<Slot> old = std::exchange(slots_, std::vector<Slot>(slot_count));
+    mask_ = slot_count - 1;
+    shift_ = 64 - static_cast<unsigned>(std::countr_zero(slot_count));
+    grow_at_ = static_cast<std::size_t>(static_cast<double>(slot_count) * max_load);
+    for (const Slot &slot : old)
+    {
+        if (slot.order == nullptr)
+            continue;
+        std::size_t i = home(slot.id);
+        while (slots_[i].order != nullptr)
+            i = (i + 1) & mask_;
+        slots_[i] = slot;
+    }
+}
@@ -0,0 +1,59 @@
+#include "order_pool.hpp"
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+// Records still handed out when the pool dies are dropped with their slab.
+static_assert(std::is_trivially_destructible_v<Order>);
+
+OrderPool::OrderPool(std::size_t slab_size) : slab_size_(slab_size)
+{
+    if (slab_size_ == 0)
+        throw std::invalid_argument("OrderPool slab size must be positive");
+}
+
+Order *OrderPool::acquire(OrderID id, OrderType type, OrderSide side, Price price, Quantity quantity)
+{
+    if (!free_list_)
+        add_slab();
+
+    Slot *slot = free_list_;
+    free_list_ = slot->next_free;
+    Order *order = new (slot->storage) Order(id, type, side, price, quantity);
+
+    if (++in_use_ > high_water_mark_)
+        high_water_mark_ = in_use_;
+    return order;
+}
+
+void OrderPool::release(Order *order)
+{
+    order->~Order();
+    Slot *slot = reinterpret_cast<Slot *>(order);
+    slot->next_free = free_list_;
+    free_list_ = slot;
+    --in_use_;
+}
+
+void OrderPool::reserve(std::size_t capacity)
+{
+    while (slabs_.size() * slab_size_ < capacity)
+        add_slab();
+}
+
+OrderPoolStats OrderPool::get_stats() const
+{
+    return {slabs_.size() * slab_size_, in_use_, high_water_mark_, slabs_.size()};
+}
+
+void OrderPool::add_slab()
+{
+    auto slab = std::make_unique<Slot[]>(slab_size_);
+    // Thread the new slots onto the free list in address order.
+    for (std::size_t i = slab_size_; i-- > 0;)
+    {
+        slab[i].next_free = free_list_;
+        free_list_ = &slab[i];
+    }
+    slabs_.push_back(std::move(slab));
+}
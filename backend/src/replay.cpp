@@ -0,0 +1,405 @@
+// Offline driver: streams an order-event file through OrderBook with no
+// networking and reports throughput, trades and the final books.
+//
+// Usage: replay [--layout tree|ladder] [--center PRICE] [--depth N] INPUT
+//
+// INPUT is one of
+//   - a CSV file (*.csv), one event per line:
+//       add,<id>,<GTC|IOC|FOK>,<buy|sell>,<price>,<quantity>[,<symbol>]
+//       add,<id>,<STOP|STOP_LIMIT>,<buy|sell>,<price>,<quantity>,<stop price>[,<symbol>]
+//       add,<id>,ICEBERG,<buy|sell>,<price>,<quantity>,<display quantity>[,<symbol>]
+//       cancel,<id>[,<symbol>]
+//       modify,<id>,<price>,<quantity>[,<symbol>]
+//     Blank lines and lines starting with '#' are skipped.
+//   - a journal directory as given to `server --journal`, whose shard-N
+//     subdirectories are replayed one after another, or a single shard-N
+//     directory. Each shard's snapshot.bin, if any, is restored first and
+//     only the records after it are replayed, as the server does on start;
+//     segments the snapshot covered have been deleted, so the journal alone
+//     is only a tail. A directory with neither segments nor a snapshot is
+//     an error.
+//   - a journal segment file (journal-NNNNNN.log), replayed on its own into
+//     empty books.
+//
+// Input is memory-mapped and parsed in place; no line is copied or
+// allocated. Events the book rejects (unknown or duplicate ids) are counted
+// and skipped, as the server would answer them with an error.
+
+#include "journal.hpp"
+#include "mapped_file.hpp"
+#include "order_book.hpp"
+#include "snapshot.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    struct ReplayStats
+    {
+        std::uint64_t events = 0;
+        std::uint64_t adds = 0;
+        std::uint64_t cancels = 0;
+        std::uint64_t modifies = 0;
+        std::uint64_t rejected = 0;
+        std::uint64_t restored = 0; // resting orders taken from a snapshot
+    };
+
+    class Replayer
+    {
+    public:
+        explicit Replayer(const BookConfig &config) : config_(config) {}
+
+        void apply(const JournalEntry &event)
+        {
+            ++stats_.events;
+            OrderBook &book = book_for(event.symbol);
+            try
+            {
+                switch (event.command)
+                {
+                case JournalCommand::add:
+                    ++stats_.adds;
+                    book.add_order(event.id, event.type, event.side, event.price, event.quantity,
+                                   event.stop_price, event.display_quantity);
+                    break;
+                case JournalCommand::cancel:
+                    ++stats_.cancels;
+                    book.cancel_order(event.id);
+                    break;
+                case JournalCommand::modify:
+                    ++stats_.modifies;
+                    book.modify_order(event.id, event.price, event.quantity);
+                    break;
+                case JournalCommand::parameters:
+                    break; // folded into its add by Journal::replay
+                }
+            }
+            catch (const std::exception &)
+            {
+                ++stats_.rejected;
+            }
+        }
+
+        // Rebuilds a book from a snapshot before any event reaches it.
+        void restore(const BookSnapshot &snapshot)
+        {
+            book_for(snapshot.symbol).restore_orders(snapshot.orders);
+            stats_.restored += snapshot.orders.size();
+        }
+
+        const ReplayStats &stats() const { return stats_; }
+        const std::unordered_map<Symbol, std::unique_ptr<OrderBook>, SymbolHash> &books() const { return books_; }
+
+    private:
+        OrderBook &book_for(const Symbol &symbol)
+        {
+            // Event files are usually dominated by one instrument; skip the hash lookup for repeats.
+            if (last_book_ && symbol == last_symbol_)
+                return *last_book_;
+            auto it = books_.find(symbol);
+            if (it == books_.end())
+                it = books_.emplace(symbol, std::make_unique<OrderBook>(&logger_, config_)).first;
+            last_symbol_ = symbol;
+            last_book_ = it->second.get();
+            return *last_book_;
+        }
+
+        BookConfig config_;
+        NullLogger logger_;
+        std::unordered_map<Symbol, std::unique_ptr<OrderBook>, SymbolHash> books_;
+        Symbol last_symbol_;
+        OrderBook *last_book_ = nullptr;
+        ReplayStats stats_;
+    };
+
+    // Splits one CSV line into fields without copying.
+    class FieldReader
+    {
+    public:
+        FieldReader(std::string_view line, std::uint64_t line_number) : rest_(line), line_number_(line_number) {}
+
+        bool done() const { return exhausted_; }
+
+        std::string_view next()
+        {
+            if (exhausted_)
+                fail("missing field");
+            std::size_t comma = rest_.find(',');
+            std::string_view field = rest_.substr(0, comma);
+            if (comma == std::string_view::npos)
+                exhausted_ = true;
+            else
+                rest_.remove_prefix(comma + 1);
+            return field;
+        }
+
+        template <typename T>
+        T number()
+        {
+            std::string_view field = next();
+            T value{};
+            auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+            if (error != std::errc() || end != field.data() + field.size())
+                fail("bad number '" + std::string(field) + "'");
+            return value;
+        }
+
+        // Optional trailing symbol column.
+        Symbol symbol()
+        {
+            if (exhausted_)
+                return default_symbol;
+            std::string_view field = next();
+            if (field.size() > Symbol::max_length)
+                fail("symbol longer than " + std::to_string(Symbol::max_length) + " characters");
+            return field.empty() ? default_symbol : Symbol(field);
+        }
+
+        [[noreturn]] void fail(const std::string &what) const
+        {
+            throw std::runtime_error("line " + std::to_string(line_number_) + ": " + what);
+        }
+
+    private:
+        std::string_view rest_;
+        std::uint64_t line_number_;
+        bool exhausted_ = false;
+    };
+
+    JournalEntry parse_csv_line(std::string_view line, std::uint64_t line_number)
+    {
+        FieldReader fields(line, line_number);
+        JournalEntry event;
+        std::string_view action = fields.next();
+        if (action == "add")
+        {
+            event.command = JournalCommand::add;
+            event.id = fields.number<OrderID>();
+            std::string_view type = fields.next();
+            if (type == "GTC")
+                event.type = OrderType::good_till_cancel;
+            else if (type == "IOC")
+                event.type = OrderType::immediate_or_cancel;
+            else if (type == "FOK")
+                event.type = OrderType::fill_or_kill;
+            else if (type == "STOP")
+                event.type = OrderType::stop;
+            else if (type == "STOP_LIMIT")
+                event.type = OrderType::stop_limit;
+            else if (type == "ICEBERG")
+                event.type = OrderType::iceberg;
+            else
+                fields.fail("unknown order type '" + std::string(type) + "'");
+            std::string_view side = fields.next();
+            if (side == "buy")
+                event.side = OrderSide::buy;
+            else if (side == "sell")
+                event.side = OrderSide::sell;
+            else
+                fields.fail("unknown side '" + std::string(side) + "'");
+            event.price = fields.number<Price>();
+            event.quantity = fields.number<Quantity>();
+            if (event.type == OrderType::stop || event.type == OrderType::stop_limit)
+                event.stop_price = fields.number<Price>();
+            else if (event.type == OrderType::iceberg)
+                event.display_quantity = fields.number<Quantity>();
+        }
+        else if (action == "cancel")
+        {
+            event.command = JournalCommand::cancel;
+            event.id = fields.number<OrderID>();
+        }
+        else if (action == "modify")
+        {
+            event.command = JournalCommand::modify;
+            event.id = fields.number<OrderID>();
+            event.price = fields.number<Price>();
+            event.quantity = fields.number<Quantity>();
+        }
+        else
+            fields.fail("unknown action '" + std::string(action) + "'");
+        event.symbol = fields.symbol();
+        if (!fields.done())
+            fields.fail("too many fields");
+        return event;
+    }
+
+    void replay_csv(const std::string &path, Replayer &replayer)
+    {
+        MappedFile file(path);
+        std::string_view text(reinterpret_cast<const char *>(file.data()), file.size());
+        std::uint64_t line_number = 0;
+        while (!text.empty())
+        {
+            std::size_t newline = text.find('\n');
+            std::string_view line = text.substr(0, newline);
+            text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+            ++line_number;
+
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (line.empty() || line.front() == '#')
+                continue;
+            replayer.apply(parse_csv_line(line, line_number));
+        }
+    }
+
+    void print_book(const Symbol &symbol, const OrderBook &book, std::size_t depth)
+    {
+        OrderLevels bids = book.get_bids();
+        OrderLevels asks = book.get_asks();
+        std::uint64_t bid_quantity = 0;
+        std::uint64_t ask_quantity = 0;
+        for (const OrderLevel &level : bids)
+            bid_quantity += level.quantity;
+        for (const OrderLevel &level : asks)
+            ask_quantity += level.quantity;
+
+        std::cout << "book symbol=" << symbol.view()
+                  << " trades=" << book.get_trade_history().next_sequence()
+                  << " bid_levels=" << bids.size() << " bid_quantity=" << bid_quantity
+                  << " ask_levels=" << asks.size() << " ask_quantity=" << ask_quantity;
+        if (!bids.empty())
+            std::cout << " best_bid=" << bids.front().price;
+        if (!asks.empty())
+            std::cout << " best_ask=" << asks.front().price;
+        std::cout << "\n";
+
+        for (std::size_t i = 0; i < depth && i < bids.size(); ++i)
+            std::cout << "  bid price=" << bids[i].price << " quantity=" << bids[i].quantity
+                      << " orders=" << bids[i].order_count << "\n";
+        for (std::size_t i = 0; i < depth && i < asks.size(); ++i)
+            std::cout << "  ask price=" << asks[i].price << " quantity=" << asks[i].quantity
+                      << " orders=" << asks[i].order_count << "\n";
+    }
+
+    // Restores one shard directory's snapshot, if any, then replays the
+    // segments after it. Throws if the directory holds neither.
+    void replay_shard(const std::filesystem::path &directory, Replayer &replayer)
+    {
+        bool has_segment = false;
+        for (const auto &entry : std::filesystem::directory_iterator(directory))
+        {
+            std::string name = entry.path().filename().string();
+            if (entry.is_regular_file() && name.starts_with("journal-") && entry.path().extension() == ".log")
+                has_segment = true;
+        }
+
+        std::uint64_t snapshot_sequence = 0;
+        std::vector<BookSnapshot> snapshot;
+        bool has_snapshot = read_snapshot((directory / snapshot_file_name).string(), snapshot_sequence, snapshot);
+        if (!has_segment && !has_snapshot)
+            throw std::runtime_error("No journal segment or snapshot in " + directory.string());
+        for (const BookSnapshot &book : snapshot)
+            replayer.restore(book);
+        Journal::replay(directory.string(), [&replayer](const JournalEntry &event) { replayer.apply(event); },
+                        snapshot_sequence);
+    }
+
+    // A directory passed to `server --journal` holds one `shard-N`
+    // subdirectory per shard; each is replayed in turn, in shard order.
+    // Any other directory is taken to be a single shard's.
+    void replay_directory(const std::filesystem::path &directory, Replayer &replayer)
+    {
+        std::vector<std::pair<std::uint64_t, std::filesystem::path>> shards;
+        for (const auto &entry : std::filesystem::directory_iterator(directory))
+        {
+            std::string name = entry.path().filename().string();
+            std::string_view number = std::string_view(name).substr(std::min<std::size_t>(name.size(), 6));
+            std::uint64_t index = 0;
+            if (!entry.is_directory() || !name.starts_with("shard-") || number.empty() ||
+                std::from_chars(number.data(), number.data() + number.size(), index).ptr !=
+                    number.data() + number.size())
+                continue;
+            shards.emplace_back(index, entry.path());
+        }
+        if (shards.empty())
+        {
+            replay_shard(directory, replayer);
+            return;
+        }
+        std::sort(shards.begin(), shards.end());
+        for (const auto &[index, path] : shards)
+            replay_shard(path, replayer);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    BookConfig config;
+    std::size_t depth = 5;
+    std::string input;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--layout" && i + 1 < argc)
+            {
+                std::string layout = argv[++i];
+                if (layout == "tree")
+                    config.layout = BookLayout::tree;
+                else if (layout == "ladder")
+                    config.layout = BookLayout::ladder;
+                else
+                    throw std::invalid_argument("Unknown layout: " + layout);
+            }
+            else if (arg == "--center" && i + 1 < argc)
+                config.center_price = std::stoi(argv[++i]);
+            else if (arg == "--depth" && i + 1 < argc)
+                depth = std::stoul(argv[++i]);
+            else
+                input = arg;
+        }
+        if (input.empty())
+        {
+            std::cerr << "Usage: replay [--layout tree|ladder] [--center PRICE] [--depth N] FILE.csv|SEGMENT.log|JOURNAL_DIR|SHARD_DIR\n";
+            return EXIT_FAILURE;
+        }
+
+        Replayer replayer(config);
+        auto apply = [&replayer](const JournalEntry &event) { replayer.apply(event); };
+        auto start = std::chrono::steady_clock::now();
+        if (std::filesystem::is_directory(input))
+            replay_directory(input, replayer);
+        else if (std::filesystem::path(input).extension() == ".csv")
+            replay_csv(input, replayer);
+        else
+            Journal::replay_segment(input, apply);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const ReplayStats &stats = replayer.stats();
+        std::uint64_t trades = 0;
+        for (const auto &[symbol, book] : replayer.books())
+            trades += book->get_trade_history().next_sequence();
+        std::cout << "restored=" << stats.restored
+                  << " events=" << stats.events
+                  << " adds=" << stats.adds
+                  << " cancels=" << stats.cancels
+                  << " modifies=" << stats.modifies
+                  << " rejected=" << stats.rejected
+                  << " trades=" << trades
+                  << " seconds=" << seconds
+                  << " events_per_sec=" << static_cast<std::uint64_t>(seconds > 0 ? stats.events / seconds : 0)
+                  << "\n";
+        for (const auto &[symbol, book] : replayer.books())
+            print_book(symbol, *book, depth);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Replay error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
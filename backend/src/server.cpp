@@ -1,42 +1,540 @@
 #include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/asio.hpp>
 #include <boost/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <limits>
 #include <memory>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "binary_protocol.hpp"
+#include "market_analytics.hpp"
 #include "order_book.hpp"
+#include "shard.hpp"
+#include "stage_stats.hpp"
 #include "logger.hpp"
 
 namespace beast = boost::beast;
+namespace http = beast::http;
 namespace websocket = beast::websocket;
 namespace net = boost::asio;
 namespace json = boost::json;
 using tcp = net::ip::tcp;
 
+class WebSocketSession;
+
+// Accepts connections and routes their requests to the shard that owns the
+// requested symbol. All networking runs on the io_context thread, which is
+// the single producer and consumer of every shard queue.
+//
+// Market data is pushed: a symbol's shard publishes updates while the symbol
+// has subscribers, and each update is serialized once per wire format and
+// the same buffer is queued on every subscribed session.
+//
+// A {"command":"analytics","symbol":...} request answers with the symbol's
+// quote and trade analytics, maintained by its shard as orders and trades
+// happen, so a client showing a few numbers need not fetch the book.
+//
+// {"command":"trades"} and {"command":"bars","resolution":"1s|1m|5m"} return
+// a symbol's recent timestamped trades or OHLCV bars, optionally within
+// "from"/"to" (milliseconds since the epoch, inclusive) and at most "limit"
+// of the most recent; the shard answers both from its trade store.
+//
+// A {"command":"stats"} request gathers every shard's counters and stage
+// histograms, adds the front end's, and answers with one JSON object; with a
+// stats interval the same report is also logged periodically.
+class WebSocketServer
+{
+    // Responses collected for a batch frame until every item has answered.
+    struct BatchReply
+    {
+        std::vector<ShardResponse> responses;
+        std::size_t outstanding = 0;
+    };
+
+    // A request waiting on a shard; holding the session keeps the connection open.
+    struct Pending
+    {
+        std::shared_ptr<WebSocketSession> session;
+        std::shared_ptr<BatchReply> batch; // null for a single request
+        std::size_t slot = 0;
+        std::size_t depth = 0;             // summary: levels per side requested
+        bool stats = false;                // one shard's part of a stats request
+    };
+
+    struct Feed
+    {
+        std::vector<std::weak_ptr<WebSocketSession>> subscribers;
+        std::size_t pending = 0; // subscribe requests still waiting for their snapshot
+    };
+
+    // Last summary seen for a (symbol, depth), with frames serialized on first use.
+    struct SummaryKey
+    {
+        Symbol symbol;
+        std::size_t depth;
+        bool operator==(const SummaryKey &other) const = default;
+    };
+
+    struct SummaryKeyHash
+    {
+        std::size_t operator()(const SummaryKey &key) const {
+            return SymbolHash{}(key.symbol) ^ (std::hash<std::size_t>{}(key.depth) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    struct CachedSummary
+    {
+        std::uint64_t version = 0;
+        OrderLevels bids;
+        OrderLevels asks;
+        std::shared_ptr<const std::string> json_frame;
+        std::shared_ptr<const std::string> binary_frame;
+    };
+
+    // Depths are client-chosen; beyond this many (symbol, depth) pairs new ones go uncached.
+    // Entries are never evicted, so an `unchanged` reply always finds its levels.
+    static constexpr std::size_t max_cached_summaries = 1024;
+
+    net::io_context &ioc_;
+    tcp::acceptor acceptor_;
+    Logger &logger_;
+    std::unordered_map<std::uint64_t, Pending> pending_;
+    std::unordered_map<Symbol, Feed, SymbolHash> feeds_;
+    std::unordered_map<SummaryKey, CachedSummary, SummaryKeyHash> summaries_;
+    std::uint64_t next_token_ = 1;
+    std::atomic<bool> poll_scheduled_{false};
+    StageStats stage_stats_;           // front-end stages
+    std::uint64_t front_end_rejects_ = 0;
+    std::chrono::steady_clock::time_point started_ = std::chrono::steady_clock::now();
+    std::chrono::seconds stats_interval_;
+    net::steady_timer stats_timer_;
+    ShardPool shards_;
+
+public:
+    WebSocketServer(net::io_context &ioc, tcp::endpoint endpoint, Logger &logger,
+                    std::size_t shard_count, LogLevel shard_log_level, const JournalConfig &journal,
+                    std::chrono::seconds stats_interval = {}, const AnalyticsConfig &analytics = {},
+                    const TradeStoreConfig &trade_store = {})
+        : ioc_(ioc), acceptor_(ioc, endpoint), logger_(logger), stats_interval_(stats_interval),
+          stats_timer_(ioc),
+          shards_(shard_count, [this] { schedule_poll(); }, shard_log_level, journal, analytics, trade_store)
+    {
+        // Calibrate the cycle counter now rather than on the first stats request.
+        stats_nanoseconds_per_tick();
+        do_accept();
+        schedule_stats_dump();
+    }
+
+    StageStats &stage_stats() { return stage_stats_; }
+    // Requests refused before reaching a shard: malformed frames and full queues.
+    void count_reject() { ++front_end_rejects_; }
+
+    // Queues a request for its shard; the response is delivered to `session`
+    // later. Unsubscribes are answered immediately.
+    bool submit(ShardRequest request, const std::shared_ptr<WebSocketSession> &session);
+
+    // Queues every request of a batch frame; `session` gets one combined
+    // reply, in request order, once all of them have answered.
+    void submit_batch(const std::vector<ShardRequest> &requests, const std::shared_ptr<WebSocketSession> &session);
+
+private:
+    void do_accept();
+    bool forward(ShardRequest request, Pending pending);
+    ShardResponse unsubscribe(const ShardRequest &request, const WebSocketSession *session);
+    void on_snapshot(const ShardResponse &response, const std::shared_ptr<WebSocketSession> &session);
+    void fan_out(const ShardResponse &update);
+    // Refreshes the cache from a changed summary; returns its entry, or null if uncached.
+    CachedSummary *on_summary(const ShardResponse &response, std::size_t depth);
+    // Drops a feed nobody is waiting on and tells the shard to stop publishing it.
+    void release_feed(const Symbol &symbol);
+    // Asks every shard for its stats; the report goes to `session`, or to the log if null.
+    void submit_stats(const std::shared_ptr<WebSocketSession> &session);
+    void finish_stats(const BatchReply &gathered, const std::shared_ptr<WebSocketSession> &session);
+    json::object stats_to_json(const BatchReply &gathered) const;
+    void schedule_stats_dump();
+
+    // Called from shard threads; coalesces wake-ups into one posted poll.
+    void schedule_poll()
+    {
+        if (!poll_scheduled_.exchange(true, std::memory_order_acq_rel))
+            net::post(ioc_, [this] { poll(); });
+    }
+
+    void poll();
+};
+
+// Speaks JSON text frames, or the binary protocol when the client offers
+// `binary_subprotocol` during the WebSocket handshake.
+//
+// Requests are pipelined: the session keeps reading while earlier requests
+// are with the shards, and replies go out through a write queue in the order
+// they complete. Reading pauses while too many replies are owed or queued.
+// Market-data frames are shared with other subscribers; a subscriber that
+// falls too far behind is disconnected rather than buffered without bound.
 class WebSocketSession : public std::enable_shared_from_this<WebSocketSession>
 {
+public:
+    using Frame = std::shared_ptr<const std::string>;
+
+private:
+    static constexpr std::size_t max_backlog = 256;
+    static constexpr std::size_t max_feed_backlog = 4096;
+    // Trades or bars per history reply: the default, and the most a request may ask for.
+    static constexpr std::int64_t default_history_limit = 1000;
+    static constexpr std::int64_t max_history_limit = 10000;
+
     websocket::stream<tcp::socket> ws_;
     beast::flat_buffer buffer_;
-    OrderBook &order_book_;
+    http::request<http::string_body> upgrade_;
+    // A queued frame; replies carry stamps for the write and total stages.
+    struct Outgoing
+    {
+        Frame frame;
+        std::uint64_t received_at = 0;
+        std::uint64_t queued_at = 0;
+    };
+
+    std::deque<Outgoing> outbox_;      // front is being written
+    std::vector<ShardRequest> batch_;  // reused across batch frames
+    std::size_t awaiting_ = 0;         // replies still owed by the shards
+    bool reading_ = false;
+    bool closed_ = false;
+    bool binary_ = false;
+    WebSocketServer &server_;
     Logger &logger_;
 
 public:
-    WebSocketSession(tcp::socket socket, OrderBook &order_book, Logger &logger)
-        : ws_(std::move(socket)), order_book_(order_book), logger_(logger) {}
+    WebSocketSession(tcp::socket socket, WebSocketServer &server, Logger &logger)
+        : ws_(std::move(socket)), server_(server), logger_(logger) {}
 
     void start() {
-        ws_.async_accept(
+        // Read the upgrade request ourselves so the subprotocol can be negotiated.
+        http::async_read(ws_.next_layer(), buffer_, upgrade_,
+            [self = shared_from_this()](boost::system::error_code ec, std::size_t /*bytes_transferred*/) {
+                self->on_upgrade(ec);
+            });
+    }
+
+    bool binary() const { return binary_; }
+    bool closed() const { return closed_; }
+
+    // Queues a market-data frame shared with other subscribers.
+    void publish(const Frame &frame) {
+        if (closed_)
+            return;
+        if (outbox_.size() >= max_feed_backlog) {
+            logger_.log("Disconnecting slow market-data subscriber");
+            closed_ = true;
+            boost::system::error_code ec;
+            ws_.next_layer().close(ec);
+            return;
+        }
+        enqueue(frame, 0);
+    }
+
+    // Serializes a response once so the frame can be shared between sessions.
+    static Frame serialize(const ShardResponse &response, bool binary) {
+        std::string out;
+        if (binary)
+            encode_response(out, response);
+        else
+            out = json::serialize(to_json(response));
+        return std::make_shared<const std::string>(std::move(out));
+    }
+
+    // Delivers a reply that was serialized ahead of time.
+    void deliver_frame(const Frame &frame, std::uint64_t received_at = 0) {
+        --awaiting_;
+        if (!closed_)
+            enqueue(frame, received_at);
+    }
+
+    // Called on the io_context thread when the shard has answered.
+    void deliver(const ShardResponse &response) {
+        --awaiting_;
+        std::uint64_t start = stats_stamp();
+        std::string out;
+        if (binary_)
+            encode_response(out, response);
+        else
+            out = json::serialize(to_json(response));
+        server_.stage_stats().record(Stage::serialize, start, stats_stamp());
+        write(std::move(out), response.received_at);
+    }
+
+    // Called once every request of a batch frame has answered.
+    void deliver_batch(const std::vector<ShardResponse> &responses) {
+        --awaiting_;
+        std::uint64_t start = stats_stamp();
+        std::string out;
+        if (binary_) {
+            encode_batch_header(out, BinaryMessage::batch_report, static_cast<std::uint32_t>(responses.size()));
+            for (const auto &response : responses)
+                encode_response(out, response);
+        } else {
+            json::array items;
+            for (const auto &response : responses)
+                items.push_back(to_json(response));
+            json::object response_obj;
+            response_obj["responses"] = std::move(items);
+            out = json::serialize(response_obj);
+        }
+        server_.stage_stats().record(Stage::serialize, start, stats_stamp());
+        // Every item was read from the same frame.
+        write(std::move(out), responses.empty() ? 0 : responses.front().received_at);
+    }
+
+private:
+    static json::object to_json(const ShardResponse &response) {
+        json::object response_obj;
+        if (!response.ok) {
+            response_obj["error"] = "Error processing request: " + response.error;
+            if (response.id != 0)
+                response_obj["id"] = std::to_string(response.id);
+            return response_obj;
+        }
+        switch (response.command) {
+        case ShardCommand::add:
+            response_obj["message"] = "Order received: " + std::to_string(response.id);
+            response_obj["status"] = order_status_name(response.status);
+            break;
+        case ShardCommand::cancel:
+            response_obj["message"] = "Order canceled: " + std::to_string(response.id);
+            break;
+        case ShardCommand::modify:
+            response_obj["message"] = "Order modified: " + std::to_string(response.id);
+            break;
+        case ShardCommand::summary:
+            response_obj["bids"] = levels_to_json(response.bids);
+            response_obj["asks"] = levels_to_json(response.asks);
+            break;
+        case ShardCommand::subscribe:
+            return market_data_to_json("snapshot", response);
+        case ShardCommand::unsubscribe:
+            response_obj["message"] = "Unsubscribed: " + std::string(response.symbol.view());
+            break;
+        case ShardCommand::market_data:
+            return market_data_to_json("update", response);
+        case ShardCommand::stats:
+            break; // reported by the server, never per shard
+        case ShardCommand::analytics:
+            return analytics_to_json(response);
+        case ShardCommand::trades:
+            return trade_history_to_json(response);
+        case ShardCommand::bars:
+            return bars_to_json(response);
+        }
+        return response_obj;
+    }
+
+    static std::uint64_t to_milliseconds(std::uint64_t ns) { return ns / 1'000'000; }
+
+    static json::object trade_history_to_json(const ShardResponse &response) {
+        json::object message;
+        message["type"] = "trades";
+        message["symbol"] = std::string(response.symbol.view());
+        json::array trades;
+        for (const TimedTrade &timed : response.trade_history) {
+            json::object trade_obj;
+            trade_obj["time"] = to_milliseconds(timed.time_ns);
+            trade_obj["price"] = timed.trade.get_price();
+            trade_obj["quantity"] = timed.trade.get_quantity();
+            trade_obj["bid_order_id"] = std::to_string(timed.trade.get_bid_order_id());
+            trade_obj["ask_order_id"] = std::to_string(timed.trade.get_ask_order_id());
+            trades.push_back(trade_obj);
+        }
+        message["trades"] = std::move(trades);
+        return message;
+    }
+
+    static json::object bars_to_json(const ShardResponse &response) {
+        json::object message;
+        message["type"] = "bars";
+        message["symbol"] = std::string(response.symbol.view());
+        message["resolution"] = bar_resolution_name(response.resolution);
+        json::array bars;
+        for (const Bar &bar : response.bars) {
+            json::object bar_obj;
+            bar_obj["time"] = to_milliseconds(bar.start_ns);
+            bar_obj["open"] = bar.open;
+            bar_obj["high"] = bar.high;
+            bar_obj["low"] = bar.low;
+            bar_obj["close"] = bar.close;
+            bar_obj["volume"] = bar.volume;
+            bar_obj["trades"] = bar.trades;
+            bars.push_back(bar_obj);
+        }
+        message["bars"] = std::move(bars);
+        return message;
+    }
+
+    static json::object analytics_to_json(const ShardResponse &response) {
+        const AnalyticsSnapshot &analytics = *response.analytics;
+        json::object message;
+        message["type"] = "analytics";
+        message["symbol"] = std::string(response.symbol.view());
+        auto level_to_json = [](const OrderLevel &level) {
+            json::object level_obj;
+            level_obj["price"] = level.price;
+            level_obj["quantity"] = level.quantity;
+            return level_obj;
+        };
+        if (analytics.has_bid)
+            message["best_bid"] = level_to_json(analytics.best_bid);
+        if (analytics.has_ask)
+            message["best_ask"] = level_to_json(analytics.best_ask);
+        if (analytics.has_bid && analytics.has_ask) {
+            message["spread"] = analytics.spread;
+            message["mid"] = analytics.mid;
+            message["microprice"] = analytics.microprice;
+        }
+        message["depth"] = analytics.depth;
+        message["bid_depth_quantity"] = analytics.bid_depth_quantity;
+        message["ask_depth_quantity"] = analytics.ask_depth_quantity;
+        message["imbalance"] = analytics.imbalance;
+        if (analytics.trades != 0)
+            message["last_price"] = analytics.last_price;
+        message["trades"] = analytics.trades;
+        message["volume"] = analytics.volume;
+        json::array windows;
+        for (const WindowAnalytics &window : analytics.windows) {
+            json::object window_obj;
+            window_obj["seconds"] = window.seconds;
+            window_obj["trades"] = window.trades;
+            window_obj["volume"] = window.volume;
+            if (window.volume != 0)
+                window_obj["vwap"] = window.vwap;
+            window_obj["volatility"] = window.volatility;
+            windows.push_back(window_obj);
+        }
+        message["windows"] = std::move(windows);
+        return message;
+    }
+
+    static json::object market_data_to_json(const char *type, const ShardResponse &response) {
+        json::object message;
+        message["type"] = type;
+        message["symbol"] = std::string(response.symbol.view());
+        message["sequence"] = response.sequence;
+        message["bids"] = levels_to_json(response.bids);
+        message["asks"] = levels_to_json(response.asks);
+        if (response.command == ShardCommand::market_data) {
+            json::array trades;
+            for (const auto &trade : response.trades) {
+                json::object trade_obj;
+                trade_obj["price"] = trade.get_price();
+                trade_obj["quantity"] = trade.get_quantity();
+                trade_obj["bid_order_id"] = std::to_string(trade.get_bid_order_id());
+                trade_obj["ask_order_id"] = std::to_string(trade.get_ask_order_id());
+                trades.push_back(trade_obj);
+            }
+            message["trades"] = std::move(trades);
+        }
+        return message;
+    }
+
+    static void encode_response(std::string &out, const ShardResponse &response) {
+        BinaryMessage request = to_binary_message(response.command);
+        if (!response.ok) {
+            encode_reject(out, request, response.id, response.error);
+        } else if (response.command == ShardCommand::summary) {
+            encode_book_summary(out, response.bids, response.asks);
+        } else if (response.command == ShardCommand::subscribe || response.command == ShardCommand::market_data) {
+            encode_market_data(out, response.command == ShardCommand::subscribe ? BinaryMessage::snapshot
+                                                                                : BinaryMessage::update,
+                               response.symbol, response.sequence, response.bids, response.asks, response.trades);
+        } else {
+            encode_execution_report(out, request, response.id, response.status,
+                                    response.filled, response.trade_count);
+        }
+    }
+
+    static BinaryMessage to_binary_message(ShardCommand command) {
+        switch (command) {
+        case ShardCommand::add:
+            return BinaryMessage::new_order;
+        case ShardCommand::cancel:
+            return BinaryMessage::cancel;
+        case ShardCommand::modify:
+            return BinaryMessage::modify;
+        case ShardCommand::summary:
+            return BinaryMessage::summary;
+        case ShardCommand::subscribe:
+            return BinaryMessage::subscribe;
+        case ShardCommand::unsubscribe:
+            return BinaryMessage::unsubscribe;
+        case ShardCommand::market_data:
+            return BinaryMessage::update;
+        case ShardCommand::stats:
+        case ShardCommand::analytics:
+        case ShardCommand::trades:
+        case ShardCommand::bars:
+            break; // JSON only
+        }
+        return BinaryMessage::new_order;
+    }
+
+    static bool offers_binary(std::string_view protocols) {
+        // Comma-separated list of tokens, in the client's order of preference.
+        while (!protocols.empty()) {
+            std::size_t comma = protocols.find(',');
+            std::string_view token = protocols.substr(0, comma);
+            while (!token.empty() && token.front() == ' ')
+                token.remove_prefix(1);
+            while (!token.empty() && token.back() == ' ')
+                token.remove_suffix(1);
+            if (token == binary_subprotocol)
+                return true;
+            if (comma == std::string_view::npos)
+                break;
+            protocols.remove_prefix(comma + 1);
+        }
+        return false;
+    }
+
+    void on_upgrade(boost::system::error_code ec) {
+        if (ec) {
+            logger_.log("WebSocket upgrade read error: " + ec.message());
+            return;
+        }
+
+        auto protocols = upgrade_[http::field::sec_websocket_protocol];
+        binary_ = offers_binary(std::string_view(protocols.data(), protocols.size()));
+        if (binary_) {
+            ws_.set_option(websocket::stream_base::decorator([](websocket::response_type &response) {
+                response.set(http::field::sec_websocket_protocol, binary_subprotocol);
+            }));
+            ws_.binary(true);
+        }
+
+        ws_.async_accept(upgrade_,
             [self = shared_from_this()](boost::system::error_code ec) {
                 self->on_accept(ec);
             });
     }
 
-private:
     void on_accept(boost::system::error_code ec) {
         if (ec) {
             logger_.log("WebSocket accept error: " + ec.message());
             return;
         }
+        maybe_read();
+    }
+
+    void maybe_read() {
+        if (reading_ || closed_ || awaiting_ + outbox_.size() >= max_backlog)
+            return;
+        reading_ = true;
         do_read();
     }
 
@@ -48,56 +546,241 @@ private:
     }
 
     void on_read(boost::system::error_code ec, std::size_t /*bytes_transferred*/) {
+        std::uint64_t received_at = stats_stamp();
+        reading_ = false;
         if (ec) {
+            closed_ = true;
             logger_.log("WebSocket read error: " + ec.message());
             return;
         }
 
-        std::string request = beast::buffers_to_string(buffer_.data());
-        buffer_.consume(buffer_.size());
+        // The frame is decoded where it sits in the buffer, then discarded.
+        auto frame = buffer_.data();
+        const auto *data = static_cast<const unsigned char *>(frame.data());
+        std::size_t size = frame.size();
 
-        json::object response_obj;
+        ShardRequest shard_request;
+        batch_.clear();
+        bool batch = false;
         try {
-            auto parsed = json::parse(request);
-            auto obj = parsed.as_object();
-
-            if(obj.contains("command") && obj["command"].as_string() == "summary") {
-                json::array bids;
-                for(const auto &level : order_book_.get_bids()) {
-                    json::object level_obj;
-                    level_obj["price"] = level.price;
-                    level_obj["quantity"] = level.quantity;
-                    bids.push_back(level_obj);
-                }
-                json::array asks;
-                for(const auto &level : order_book_.get_asks()) {
-                    json::object level_obj;
-                    level_obj["price"] = level.price;
-                    level_obj["quantity"] = level.quantity;
-                    asks.push_back(level_obj);
+            if (binary_) {
+                batch = size > 0 && static_cast<BinaryMessage>(data[0]) == BinaryMessage::batch;
+                if (batch) {
+                    decode_binary_batch(data, size, [this](const BinaryRequest &request) {
+                        batch_.push_back(to_shard_request(request));
+                    });
+                } else {
+                    shard_request = to_shard_request(decode_binary_request(data, size));
                 }
-                response_obj["bids"] = bids;
-                response_obj["asks"] = asks;
             } else {
-                OrderID id = std::stoull(std::string(obj.at("id").as_string()));
-                OrderType type = (obj.at("type").as_string() == "GTC")
-                                    ? OrderType::good_till_cancel
-                                    : OrderType::immediate_or_cancel;
-                OrderSide side = (obj.at("side").as_string() == "buy")
-                                    ? OrderSide::buy
-                                    : OrderSide::sell;
-                Price price = static_cast<Price>(obj.at("price").as_int64());
-                Quantity quantity = static_cast<Quantity>(obj.at("quantity").as_int64());
-
-                order_book_.add_order(id, type, side, price, quantity);
-                response_obj["message"] = "Order received: " + std::to_string(id);
+                auto parsed = json::parse(std::string_view(reinterpret_cast<const char *>(data), size));
+                // A top-level array is a batch of ordinary requests.
+                batch = parsed.is_array();
+                if (batch) {
+                    for (const auto &item : parsed.as_array())
+                        batch_.push_back(parse_request(item.as_object()));
+                } else {
+                    shard_request = parse_request(parsed.as_object());
+                }
             }
         } catch(const std::exception &e) {
-            response_obj["error"] = std::string("Error processing request: ") + e.what();
+            buffer_.consume(buffer_.size());
+            write_error(e.what(), binary_ && size > 0 ? static_cast<BinaryMessage>(data[0]) : BinaryMessage::new_order);
+            maybe_read();
+            return;
+        }
+        buffer_.consume(buffer_.size());
+        server_.stage_stats().record(Stage::parse, received_at, stats_stamp());
+        shard_request.received_at = received_at;
+        for (ShardRequest &item : batch_)
+            item.received_at = received_at;
+
+        // Counted before submitting: some replies are delivered synchronously.
+        ++awaiting_;
+        if (batch) {
+            server_.submit_batch(batch_, shared_from_this());
+        } else if (!server_.submit(shard_request, shared_from_this())) {
+            --awaiting_;
+            write_error("server busy", to_binary_message(shard_request.command), shard_request.id);
+        }
+        maybe_read();
+    }
+
+    void write_error(const std::string &message, BinaryMessage request, OrderID id = 0) {
+        server_.count_reject();
+        std::string out;
+        if (binary_) {
+            encode_reject(out, request, id, message);
+        } else {
+            json::object response_obj;
+            response_obj["error"] = "Error processing request: " + message;
+            if (id != 0)
+                response_obj["id"] = std::to_string(id);
+            out = json::serialize(response_obj);
+        }
+        write(std::move(out));
+    }
+
+    static ShardRequest to_shard_request(const BinaryRequest &binary) {
+        ShardRequest request;
+        request.symbol = binary.symbol;
+        request.id = binary.id;
+        request.type = binary.order_type;
+        request.side = binary.side;
+        request.price = binary.price;
+        request.quantity = binary.quantity;
+        request.stop_price = binary.stop_price;
+        request.display_quantity = binary.display_quantity;
+        switch (binary.type) {
+        case BinaryMessage::cancel:
+            request.command = ShardCommand::cancel;
+            break;
+        case BinaryMessage::modify:
+            request.command = ShardCommand::modify;
+            break;
+        case BinaryMessage::summary:
+            request.command = ShardCommand::summary;
+            request.depth = binary.depth == 0 ? std::numeric_limits<std::size_t>::max() : binary.depth;
+            break;
+        case BinaryMessage::subscribe:
+            request.command = ShardCommand::subscribe;
+            break;
+        case BinaryMessage::unsubscribe:
+            request.command = ShardCommand::unsubscribe;
+            break;
+        default:
+            request.command = ShardCommand::add;
+            break;
         }
+        return request;
+    }
+
+    static ShardRequest parse_request(const json::object &obj) {
+        ShardRequest request;
+        request.symbol = obj.contains("symbol")
+                             ? Symbol(std::string_view(obj.at("symbol").as_string()))
+                             : default_symbol;
+
+        std::string_view command = obj.contains("command")
+                                       ? std::string_view(obj.at("command").as_string())
+                                       : std::string_view("new");
+        if (command == "summary") {
+            // Optional "depth" limits the response to the best N levels per side; 0, like omitting it, means all.
+            request.command = ShardCommand::summary;
+            std::int64_t depth = obj.contains("depth") ? obj.at("depth").as_int64() : 0;
+            if (depth < 0)
+                throw std::runtime_error("depth must not be negative");
+            request.depth = depth == 0 ? std::numeric_limits<std::size_t>::max() : static_cast<std::size_t>(depth);
+        } else if (command == "subscribe") {
+            request.command = ShardCommand::subscribe;
+        } else if (command == "unsubscribe") {
+            request.command = ShardCommand::unsubscribe;
+        } else if (command == "stats") {
+            request.command = ShardCommand::stats;
+        } else if (command == "analytics") {
+            request.command = ShardCommand::analytics;
+        } else if (command == "trades" || command == "bars") {
+            request.command = command == "trades" ? ShardCommand::trades : ShardCommand::bars;
+            if (request.command == ShardCommand::bars) {
+                std::string_view resolution = obj.contains("resolution")
+                                                  ? std::string_view(obj.at("resolution").as_string())
+                                                  : std::string_view("1s");
+                if (resolution == "1s")
+                    request.resolution = BarResolution::one_second;
+                else if (resolution == "1m")
+                    request.resolution = BarResolution::one_minute;
+                else if (resolution == "5m")
+                    request.resolution = BarResolution::five_minutes;
+                else
+                    throw std::runtime_error("Unknown resolution");
+            }
+            // Milliseconds on the wire; an open end saturates rather than wraps.
+            auto to_ns = [](std::int64_t ms) {
+                if (ms <= 0)
+                    return std::uint64_t{0};
+                std::uint64_t value = static_cast<std::uint64_t>(ms);
+                return value > std::numeric_limits<std::uint64_t>::max() / 1'000'000
+                           ? std::numeric_limits<std::uint64_t>::max()
+                           : value * 1'000'000;
+            };
+            request.from_ns = obj.contains("from") ? to_ns(obj.at("from").as_int64()) : 0;
+            // "to" covers its whole millisecond.
+            request.to_ns = std::numeric_limits<std::uint64_t>::max();
+            if (obj.contains("to")) {
+                std::uint64_t to = to_ns(obj.at("to").as_int64());
+                if (to <= request.to_ns - 999'999)
+                    request.to_ns = to + 999'999;
+            }
+            std::int64_t limit = obj.contains("limit") ? obj.at("limit").as_int64() : default_history_limit;
+            request.limit = static_cast<std::uint32_t>(std::clamp<std::int64_t>(limit, 0, max_history_limit));
+        } else if (command == "cancel") {
+            request.command = ShardCommand::cancel;
+            request.id = parse_order_id(obj.at("id"));
+        } else if (command == "modify") {
+            request.command = ShardCommand::modify;
+            request.id = parse_order_id(obj.at("id"));
+            request.price = static_cast<Price>(obj.at("price").as_int64());
+            request.quantity = static_cast<Quantity>(obj.at("quantity").as_int64());
+        } else if (command == "new") {
+            request.command = ShardCommand::add;
+            request.id = parse_order_id(obj.at("id"));
+            std::string_view type = obj.at("type").as_string();
+            request.type = (type == "GTC")          ? OrderType::good_till_cancel
+                           : (type == "FOK")        ? OrderType::fill_or_kill
+                           : (type == "STOP")       ? OrderType::stop
+                           : (type == "STOP_LIMIT") ? OrderType::stop_limit
+                           : (type == "ICEBERG")    ? OrderType::iceberg
+                                                    : OrderType::immediate_or_cancel;
+            request.side = (obj.at("side").as_string() == "buy")
+                               ? OrderSide::buy
+                               : OrderSide::sell;
+            // A stop trades at any price once triggered, so it needs no limit.
+            if (request.type != OrderType::stop || obj.contains("price"))
+                request.price = static_cast<Price>(obj.at("price").as_int64());
+            request.quantity = static_cast<Quantity>(obj.at("quantity").as_int64());
+            if (request.type == OrderType::stop || request.type == OrderType::stop_limit)
+                request.stop_price = static_cast<Price>(obj.at("stop_price").as_int64());
+            else if (request.type == OrderType::iceberg)
+                request.display_quantity = static_cast<Quantity>(obj.at("display_quantity").as_int64());
+        } else {
+            throw std::runtime_error("Unknown command");
+        }
+        return request;
+    }
+
+    // Ids arrive as strings from the React client and tester; plain integers are accepted too.
+    static OrderID parse_order_id(const json::value &id) {
+        if (id.is_string())
+            return std::stoull(std::string(std::string_view(id.as_string())));
+        return static_cast<OrderID>(id.as_int64());
+    }
+
+    static json::array levels_to_json(const OrderLevels &levels) {
+        json::array result;
+        for (const auto &level : levels) {
+            json::object level_obj;
+            level_obj["price"] = level.price;
+            level_obj["quantity"] = level.quantity;
+            result.push_back(level_obj);
+        }
+        return result;
+    }
+
+    void write(std::string response, std::uint64_t received_at = 0) {
+        if (closed_)
+            return;
+        enqueue(std::make_shared<const std::string>(std::move(response)), received_at);
+    }
+
+    // `received_at` is 0 for frames that answer no request, which are not timed.
+    void enqueue(Frame frame, std::uint64_t received_at) {
+        outbox_.push_back({std::move(frame), received_at, received_at != 0 ? stats_stamp() : 0});
+        if (outbox_.size() == 1)
+            do_write();
+    }
 
-        std::string response = json::serialize(response_obj);
-        ws_.async_write(net::buffer(response),
+    void do_write() {
+        ws_.async_write(net::buffer(*outbox_.front().frame),
             [self = shared_from_this()](boost::system::error_code ec, std::size_t /*bytes_transferred*/) {
                 self->on_write(ec);
             });
@@ -105,54 +788,411 @@ private:
 
     void on_write(boost::system::error_code ec) {
         if (ec) {
+            closed_ = true;
+            outbox_.clear();
             logger_.log("WebSocket write error: " + ec.message());
             return;
         }
-        do_read();
+        std::uint64_t written_at = stats_stamp();
+        server_.stage_stats().record(Stage::write, outbox_.front().queued_at, written_at);
+        server_.stage_stats().record(Stage::total, outbox_.front().received_at, written_at);
+        outbox_.pop_front();
+        if (!outbox_.empty())
+            do_write();
+        maybe_read();
     }
 };
 
-class WebSocketServer
-{
-    net::io_context &ioc_;
-    tcp::acceptor acceptor_;
-    OrderBook order_book_;
-    Logger &logger_;
+void WebSocketServer::do_accept() {
+    acceptor_.async_accept(
+        [this](boost::system::error_code ec, tcp::socket socket) {
+            if (!ec) {
+                std::make_shared<WebSocketSession>(std::move(socket), *this, logger_)->start();
+            } else {
+                logger_.log("Accept error: " + ec.message());
+            }
+            do_accept();
+        });
+}
 
-public:
-    WebSocketServer(net::io_context &ioc, tcp::endpoint endpoint, Logger &logger)
-        : ioc_(ioc), acceptor_(ioc, endpoint), order_book_(&logger), logger_(logger)
-    {
-        do_accept();
+bool WebSocketServer::submit(ShardRequest request, const std::shared_ptr<WebSocketSession> &session) {
+    if (request.command == ShardCommand::stats) {
+        submit_stats(session);
+        return true;
+    }
+    request.token = next_token_++;
+    if (request.command == ShardCommand::unsubscribe) {
+        session->deliver(unsubscribe(request, session.get()));
+        return true;
     }
+    return forward(request, Pending{session, nullptr, 0, request.depth});
+}
 
-private:
-    void do_accept() {
-        acceptor_.async_accept(
-            [this](boost::system::error_code ec, tcp::socket socket) {
-                if (!ec) {
-                    std::make_shared<WebSocketSession>(std::move(socket), order_book_, logger_)->start();
-                } else {
-                    logger_.log("Accept error: " + ec.message());
-                }
-                do_accept();
-            });
+void WebSocketServer::submit_batch(const std::vector<ShardRequest> &requests,
+                                   const std::shared_ptr<WebSocketSession> &session) {
+    auto batch = std::make_shared<BatchReply>();
+    batch->responses.resize(requests.size());
+    batch->outstanding = requests.size();
+    for (std::size_t slot = 0; slot < requests.size(); ++slot) {
+        ShardRequest request = requests[slot];
+        request.token = next_token_++;
+        if (request.command == ShardCommand::unsubscribe) {
+            batch->responses[slot] = unsubscribe(request, session.get());
+            --batch->outstanding;
+            continue;
+        }
+        if (request.command != ShardCommand::stats && forward(request, Pending{session, batch, slot, request.depth}))
+            continue;
+        ShardResponse &refused = batch->responses[slot];
+        refused.command = request.command;
+        refused.symbol = request.symbol;
+        refused.id = request.id;
+        refused.ok = false;
+        refused.error = request.command == ShardCommand::stats ? "stats cannot be batched" : "server busy";
+        refused.received_at = request.received_at;
+        --batch->outstanding;
+        ++front_end_rejects_;
+    }
+    if (batch->outstanding == 0)
+        session->deliver_batch(batch->responses);
+}
+
+bool WebSocketServer::forward(ShardRequest request, Pending pending) {
+    if (request.command == ShardCommand::summary) {
+        auto cached = summaries_.find(SummaryKey{request.symbol, request.depth});
+        if (cached != summaries_.end())
+            request.known_version = cached->second.version;
+    }
+    request.submitted_at = stats_stamp();
+    if (!shards_.submit(request))
+        return false;
+    if (request.command == ShardCommand::subscribe)
+        ++feeds_[request.symbol].pending;
+    pending_.emplace(request.token, std::move(pending));
+    return true;
+}
+
+ShardResponse WebSocketServer::unsubscribe(const ShardRequest &request, const WebSocketSession *session) {
+    ShardResponse response;
+    response.command = ShardCommand::unsubscribe;
+    response.symbol = request.symbol;
+    auto it = feeds_.find(request.symbol);
+    if (it != feeds_.end()) {
+        std::erase_if(it->second.subscribers, [session](const std::weak_ptr<WebSocketSession> &weak) {
+            auto subscriber = weak.lock();
+            return !subscriber || subscriber.get() == session;
+        });
+        if (it->second.subscribers.empty() && it->second.pending == 0)
+            release_feed(request.symbol);
+    }
+    return response;
+}
+
+void WebSocketServer::on_snapshot(const ShardResponse &response, const std::shared_ptr<WebSocketSession> &session) {
+    Feed &feed = feeds_[response.symbol];
+    --feed.pending;
+    // Updates published after the snapshot follow it on the same queue, so the
+    // session starts receiving them from here.
+    if (response.ok) {
+        bool subscribed = std::any_of(feed.subscribers.begin(), feed.subscribers.end(),
+                                      [&session](const auto &weak) { return weak.lock() == session; });
+        if (!subscribed)
+            feed.subscribers.push_back(session);
+    }
+    if (feed.subscribers.empty() && feed.pending == 0)
+        release_feed(response.symbol);
+}
+
+void WebSocketServer::fan_out(const ShardResponse &update) {
+    auto it = feeds_.find(update.symbol);
+    if (it == feeds_.end()) {
+        // Published before the shard saw the last unsubscribe.
+        release_feed(update.symbol);
+        return;
+    }
+
+    WebSocketSession::Frame json_frame;
+    WebSocketSession::Frame binary_frame;
+    std::erase_if(it->second.subscribers, [&](const std::weak_ptr<WebSocketSession> &weak) {
+        auto session = weak.lock();
+        if (!session || session->closed())
+            return true;
+        auto &frame = session->binary() ? binary_frame : json_frame;
+        if (!frame)
+            frame = WebSocketSession::serialize(update, session->binary());
+        session->publish(frame);
+        return false;
+    });
+    if (it->second.subscribers.empty() && it->second.pending == 0)
+        release_feed(update.symbol);
+}
+
+WebSocketServer::CachedSummary *WebSocketServer::on_summary(const ShardResponse &response, std::size_t depth) {
+    SummaryKey key{response.symbol, depth};
+    auto it = summaries_.find(key);
+    if (it == summaries_.end()) {
+        if (summaries_.size() >= max_cached_summaries)
+            return nullptr;
+        it = summaries_.emplace(key, CachedSummary{}).first;
+    }
+    CachedSummary &cached = it->second;
+    if (!response.unchanged && cached.version != response.version)
+        cached = CachedSummary{response.version, response.bids, response.asks, nullptr, nullptr};
+    return &cached;
+}
+
+void WebSocketServer::release_feed(const Symbol &symbol) {
+    feeds_.erase(symbol);
+    ShardRequest request;
+    request.command = ShardCommand::unsubscribe;
+    request.symbol = symbol;
+    // Token 0 is never pending, so the acknowledgement is dropped. If the queue
+    // is full the next stray update retries.
+    shards_.submit(request);
+}
+
+void WebSocketServer::submit_stats(const std::shared_ptr<WebSocketSession> &session) {
+    auto gathered = std::make_shared<BatchReply>();
+    gathered->responses.resize(shards_.size());
+    gathered->outstanding = shards_.size();
+    for (std::size_t shard = 0; shard < shards_.size(); ++shard) {
+        ShardRequest request;
+        request.command = ShardCommand::stats;
+        request.token = next_token_++;
+        request.submitted_at = stats_stamp();
+        if (shards_.submit_to(shard, request)) {
+            pending_.emplace(request.token, Pending{session, gathered, shard, 0, true});
+            continue;
+        }
+        // A shard too busy to answer is reported without its numbers.
+        gathered->responses[shard].ok = false;
+        --gathered->outstanding;
+    }
+    if (gathered->outstanding == 0)
+        finish_stats(*gathered, session);
+}
+
+void WebSocketServer::finish_stats(const BatchReply &gathered, const std::shared_ptr<WebSocketSession> &session) {
+    json::object report;
+    report["stats"] = stats_to_json(gathered);
+    std::string out = json::serialize(report);
+    if (session)
+        session->deliver_frame(std::make_shared<const std::string>(std::move(out)));
+    else
+        logger_.log("Stats " + out);
+}
+
+json::object WebSocketServer::stats_to_json(const BatchReply &gathered) const {
+    std::uint64_t orders = 0, cancels = 0, modifies = 0, trades = 0, rejects = front_end_rejects_;
+    StageStats stages = stage_stats_;
+    json::array shards;
+    for (std::size_t shard = 0; shard < gathered.responses.size(); ++shard) {
+        const ShardResponse &response = gathered.responses[shard];
+        json::object shard_obj;
+        shard_obj["shard"] = shard;
+        if (!response.ok || !response.stats) {
+            shard_obj["error"] = "shard busy";
+            shards.push_back(shard_obj);
+            continue;
+        }
+        const ShardStats &shard_stats = *response.stats;
+        orders += shard_stats.orders;
+        cancels += shard_stats.cancels;
+        modifies += shard_stats.modifies;
+        trades += shard_stats.trades;
+        rejects += shard_stats.rejects;
+        stages.merge(shard_stats.stages);
+        shard_obj["books"] = shard_stats.books;
+        shard_obj["request_queue"] = shard_stats.request_queue_depth;
+        shard_obj["response_queue"] = shard_stats.response_queue_depth;
+        shard_obj["orders"] = shard_stats.orders;
+        shard_obj["cancels"] = shard_stats.cancels;
+        shard_obj["modifies"] = shard_stats.modifies;
+        shard_obj["trades"] = shard_stats.trades;
+        shard_obj["rejects"] = shard_stats.rejects;
+        shards.push_back(shard_obj);
     }
-};
 
-int main() {
+    json::object stats;
+    stats["uptime_s"] = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - started_).count();
+    stats["orders"] = orders;
+    stats["cancels"] = cancels;
+    stats["modifies"] = modifies;
+    stats["trades"] = trades;
+    stats["rejects"] = rejects;
+    stats["in_flight"] = pending_.size();
+    stats["shards"] = std::move(shards);
+    if (stats_compiled) {
+        // Latencies in nanoseconds.
+        double ns_per_tick = stats_nanoseconds_per_tick();
+        auto ns = [ns_per_tick](double ticks) { return static_cast<std::uint64_t>(ticks * ns_per_tick + 0.5); };
+        json::object stage_objs;
+        for (std::size_t i = 0; i < stage_count; ++i) {
+            Stage stage = static_cast<Stage>(i);
+            const LatencyHistogram &histogram = stages.histogram(stage);
+            json::object stage_obj;
+            stage_obj["count"] = histogram.count();
+            stage_obj["mean"] = ns(histogram.mean());
+            stage_obj["p50"] = ns(static_cast<double>(histogram.percentile(50)));
+            stage_obj["p99"] = ns(static_cast<double>(histogram.percentile(99)));
+            stage_obj["p99.9"] = ns(static_cast<double>(histogram.percentile(99.9)));
+            stage_obj["max"] = ns(static_cast<double>(histogram.max()));
+            stage_objs[stage_name(stage)] = std::move(stage_obj);
+        }
+        stats["stages_ns"] = std::move(stage_objs);
+    }
+    return stats;
+}
+
+void WebSocketServer::schedule_stats_dump() {
+    if (stats_interval_.count() <= 0)
+        return;
+    stats_timer_.expires_after(stats_interval_);
+    stats_timer_.async_wait([this](boost::system::error_code ec) {
+        if (ec)
+            return;
+        submit_stats(nullptr);
+        schedule_stats_dump();
+    });
+}
+
+void WebSocketServer::poll() {
+    poll_scheduled_.store(false, std::memory_order_release);
+    std::uint64_t polled_at = stats_stamp();
+    shards_.poll_responses([this, polled_at](ShardResponse &&response) {
+        if (response.command == ShardCommand::market_data) {
+            fan_out(response);
+            return;
+        }
+        auto it = pending_.find(response.token);
+        if (it == pending_.end())
+            return;
+        Pending pending = std::move(it->second);
+        pending_.erase(it);
+        stage_stats_.record(Stage::dispatch, response.published_at, polled_at);
+        if (pending.stats) {
+            pending.batch->responses[pending.slot] = std::move(response);
+            if (--pending.batch->outstanding == 0)
+                finish_stats(*pending.batch, pending.session);
+            return;
+        }
+        if (response.command == ShardCommand::subscribe)
+            on_snapshot(response, pending.session);
+        // Summaries are cached until the book's version moves; idle books are answered from here.
+        CachedSummary *cached = nullptr;
+        if (response.command == ShardCommand::summary && response.ok)
+            cached = on_summary(response, pending.depth);
+        if (cached) {
+            if (!pending.batch) {
+                bool binary = pending.session->binary();
+                auto &frame = binary ? cached->binary_frame : cached->json_frame;
+                if (!frame) {
+                    response.bids = cached->bids;
+                    response.asks = cached->asks;
+                    frame = WebSocketSession::serialize(response, binary);
+                }
+                pending.session->deliver_frame(frame, response.received_at);
+                return;
+            }
+            if (response.unchanged) {
+                response.bids = cached->bids;
+                response.asks = cached->asks;
+            }
+        }
+        if (!pending.batch) {
+            pending.session->deliver(response);
+            return;
+        }
+        pending.batch->responses[pending.slot] = std::move(response);
+        if (--pending.batch->outstanding == 0)
+            pending.session->deliver_batch(pending.batch->responses);
+    });
+}
+
+int main(int argc, char *argv[]) {
     try {
         net::io_context ioc{1};
         tcp::endpoint endpoint(tcp::v4(), 8080);
 
-        // Create a logger instance (e.g., ConsoleLogger)
-        ConsoleLogger logger; // Make sure ConsoleLogger is defined in logger.hpp
-        WebSocketServer server(ioc, endpoint, logger);
+        // One core for networking, the rest for shards unless given on the command line.
+        // Options: --journal DIR persists accepted orders and replays them on start;
+        // --fsync none|group|every picks when journal records reach the disk (default group);
+        // --snapshot-every N snapshots the books every N journal records (0: only on shutdown);
+        // --stats-every S logs the stats report every S seconds;
+        // --analytics-depth N sums N levels per side into the book imbalance (default 5);
+        // --analytics-windows S,S,... sets the rolling VWAP and volatility windows in seconds (default 10,60,300);
+        // --trade-history N keeps the latest N timestamped trades per symbol, and at most one block more (default 1048576);
+        // --debug logs every order, cancel and trade (default: info and above only).
+        unsigned cores = std::max(2u, std::thread::hardware_concurrency());
+        std::size_t shard_count = cores - 1;
+        JournalConfig journal;
+        std::chrono::seconds stats_interval{0};
+        AnalyticsConfig analytics;
+        TradeStoreConfig trade_store;
+        LogLevel log_level = LogLevel::info;
+        bool shards_given = false;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--journal" && i + 1 < argc) {
+                journal.directory = argv[++i];
+            } else if (arg == "--fsync" && i + 1 < argc) {
+                std::string policy = argv[++i];
+                if (policy == "none")
+                    journal.sync = JournalSync::none;
+                else if (policy == "group")
+                    journal.sync = JournalSync::group;
+                else if (policy == "every")
+                    journal.sync = JournalSync::every;
+                else
+                    throw std::invalid_argument("Unknown fsync policy: " + policy);
+            } else if (arg == "--snapshot-every" && i + 1 < argc) {
+                journal.snapshot_interval = std::stoull(argv[++i]);
+            } else if (arg == "--stats-every" && i + 1 < argc) {
+                stats_interval = std::chrono::seconds(std::stoul(argv[++i]));
+            } else if (arg == "--analytics-depth" && i + 1 < argc) {
+                analytics.depth = std::stoul(argv[++i]);
+            } else if (arg == "--analytics-windows" && i + 1 < argc) {
+                std::string list = argv[++i];
+                analytics.windows.clear();
+                for (std::size_t start = 0; start <= list.size();) {
+                    std::size_t comma = std::min(list.find(',', start), list.size());
+                    analytics.windows.push_back(static_cast<std::uint32_t>(std::stoul(list.substr(start, comma - start))));
+                    start = comma + 1;
+                }
+            } else if (arg == "--trade-history" && i + 1 < argc) {
+                trade_store.max_trades = std::stoull(argv[++i]);
+            } else if (arg == "--debug") {
+                log_level = LogLevel::debug;
+            } else if (!shards_given && !arg.empty() && arg.find_first_not_of("0123456789") == std::string::npos) {
+                shard_count = std::stoul(arg);
+                shards_given = true;
+            } else {
+                // Unknown flags, known ones missing their value and a second number are all mistakes.
+                std::cerr << "Unknown or incomplete argument: " << arg << "\n"
+                          << "Usage: server [SHARDS] [--journal DIR] [--fsync none|group|every] [--snapshot-every N]\n"
+                          << "              [--stats-every S] [--analytics-depth N] [--analytics-windows S,S,...]\n"
+                          << "              [--trade-history N] [--debug]" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        // Order and trade events are formatted on the loggers' writer threads.
+        AsyncLogger logger(std::cout, log_level);
+        WebSocketServer server(ioc, endpoint, logger, shard_count, log_level, journal, stats_interval,
+                               analytics, trade_store);
+
+        // Stop cleanly on SIGINT/SIGTERM so shards can write their final snapshots.
+        net::signal_set signals(ioc, SIGINT, SIGTERM);
+        signals.async_wait([&ioc](const boost::system::error_code &, int) { ioc.stop(); });
 
-        logger.log("Async WebSocket server started on port 8080");
+        logger.log("Async WebSocket server started on port 8080 with " +
+                   std::to_string(shard_count) + " shard(s)" +
+                   (journal.directory.empty() ? "" : ", journaling to " + journal.directory));
         ioc.run();
     } catch (std::exception &e) {
         std::cerr << "Server error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
     }
-    return 0;
+    return EXIT_SUCCESS;
 }
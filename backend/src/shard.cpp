@@ -0,0 +1,539 @@
+#include "shard.hpp"
+#include "snapshot.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    std::string snapshot_path(const std::string &journal_directory)
+    {
+        return (std::filesystem::path(journal_directory) / snapshot_file_name).string();
+    }
+
+    // Monotonic nanoseconds for the analytics windows.
+    std::uint64_t analytics_now()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+    }
+
+    // Nanoseconds since the epoch for trade times.
+    std::uint64_t wall_clock_now()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::system_clock::now().time_since_epoch())
+                                              .count());
+    }
+}
+
+ShardPool::ShardPool(std::size_t shard_count, std::function<void()> notify,
+                     LogLevel log_level, const JournalConfig &journal, const AnalyticsConfig &analytics,
+                     const TradeStoreConfig &trade_store, std::size_t queue_capacity)
+    : notify_(std::move(notify))
+{
+    if (shard_count == 0)
+        throw std::invalid_argument("ShardPool needs at least one shard");
+    // Books are created lazily; reject a bad analytics config before any shard starts.
+    MarketAnalytics{analytics};
+    bool journaled = !journal.directory.empty();
+    if (journaled)
+        check_journal_layout(journal.directory, shard_count);
+
+    shards_.reserve(shard_count);
+    for (std::size_t i = 0; i < shard_count; ++i)
+    {
+        JournalConfig shard_journal = journal;
+        shard_journal.directory = (std::filesystem::path(journal.directory) / ("shard-" + std::to_string(i))).string();
+        shards_.push_back(std::make_unique<Shard>(queue_capacity, log_level, notify_,
+                                                  journaled ? &shard_journal : nullptr, analytics,
+                                                  trade_store));
+    }
+    // Shards recover in parallel; serve nothing until all of them have.
+    for (auto &shard : shards_)
+        shard->wait_ready();
+}
+
+ShardPool::~ShardPool() = default;
+
+std::size_t ShardPool::shard_for(const Symbol &symbol) const
+{
+    return SymbolHash{}(symbol) % shards_.size();
+}
+
+bool ShardPool::submit(const ShardRequest &request)
+{
+    return shards_[shard_for(request.symbol)]->requests.try_push(request);
+}
+
+bool ShardPool::submit_to(std::size_t shard, const ShardRequest &request)
+{
+    return shards_[shard]->requests.try_push(request);
+}
+
+void ShardPool::check_journal_layout(const std::string &directory, std::size_t shard_count)
+{
+    std::filesystem::create_directories(directory);
+    std::string path = (std::filesystem::path(directory) / "shards").string();
+    std::ifstream existing(path);
+    std::size_t recorded = 0;
+    if (existing >> recorded)
+    {
+        if (recorded != shard_count)
+            throw std::invalid_argument("Journal in " + directory + " was written by " + std::to_string(recorded) +
+                                        " shard(s); restart with that shard count");
+        return;
+    }
+
+    std::ofstream layout(path, std::ios::trunc);
+    if (!(layout << shard_count << '\n') || !layout.flush())
+        throw std::runtime_error("Cannot write " + path);
+}
+
+ShardPool::Shard::Shard(std::size_t queue_capacity, LogLevel log_level, const std::function<void()> &notify,
+                        const JournalConfig *journal, const AnalyticsConfig &analytics,
+                        const TradeStoreConfig &trade_store)
+    : requests(queue_capacity), responses(queue_capacity), notify_(notify), log_level_(log_level),
+      logger_(std::cout, log_level), analytics_config_(analytics), trade_store_config_(trade_store),
+      journal_(journal ? std::make_unique<Journal>(*journal) : nullptr),
+      snapshot_interval_(journal ? journal->snapshot_interval : 0), thread_([this] { run(); })
+{
+    staged_.reserve(max_pass_size);
+}
+
+ShardPool::Shard::~Shard()
+{
+    running_.store(false, std::memory_order_release);
+    thread_.join();
+}
+
+void ShardPool::Shard::run()
+{
+    try
+    {
+        if (journal_)
+            recover();
+    }
+    catch (...)
+    {
+        ready_.set_exception(std::current_exception());
+        return;
+    }
+    // Recovered books start tracking from their restored state.
+    tracking_ = true;
+    for (auto &[symbol, entry] : books_)
+        track(entry);
+    ready_.set_value();
+
+    ShardRequest request;
+    ShardResponse response;
+    unsigned idle_spins = 0;
+
+    while (running_.load(std::memory_order_acquire))
+    {
+        while (staged_.size() < max_pass_size && requests.try_pop(request))
+        {
+            stats_.stages.record(Stage::queue, request.submitted_at, stats_stamp());
+            response = ShardResponse{};
+            handle(request, response);
+            response.handled_at = stats_stamp();
+            // A snapshot joins the pass's market data, after the updates it
+            // covers and before those it does not.
+            if (response.command == ShardCommand::subscribe && response.ok)
+                updates_.push_back(std::move(response));
+            else
+                staged_.push_back(std::move(response));
+        }
+        bool published = !staged_.empty() || !updates_.empty();
+
+        // Changes from the whole pass feed the analytics and become one update per subscribed book.
+        for (BookEntry *entry : touched_)
+        {
+            entry->touched = false;
+            flush(*entry);
+        }
+        touched_.clear();
+
+        // Group commit: nothing from this pass is acknowledged before its journal records are durable.
+        if (published && journal_ && journal_error_.empty())
+        {
+            try
+            {
+                journal_->commit();
+            }
+            catch (const std::exception &e)
+            {
+                fail_journal(e.what());
+            }
+        }
+        if (!journal_error_.empty())
+            hold_unjournaled();
+        std::uint64_t published_at = stats_stamp();
+        for (ShardResponse &staged : staged_)
+        {
+            stats_.stages.record(Stage::commit, staged.handled_at, published_at);
+            staged.published_at = published_at;
+            publish(std::move(staged));
+        }
+        staged_.clear();
+
+        if (journal_ && journal_error_.empty() && snapshot_interval_ != 0 &&
+            journal_->last_sequence() - snapshot_sequence_ >= snapshot_interval_)
+            take_snapshot();
+
+        // Market data follows the replies of its pass, in the order it was queued.
+        for (ShardResponse &update : updates_)
+        {
+            update.published_at = published_at;
+            publish(std::move(update));
+        }
+        updates_.clear();
+
+        if (published)
+        {
+            notify_();
+            idle_spins = 0;
+        }
+        else if (++idle_spins < 1024)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    // A final snapshot makes the next start a restore with nothing to replay.
+    if (journal_ && journal_error_.empty() && journal_->last_sequence() != snapshot_sequence_)
+        take_snapshot();
+}
+
+void ShardPool::Shard::recover()
+{
+    // Recovered commands were logged when first accepted.
+    logger_.set_level(LogLevel::off);
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<BookSnapshot> snapshot;
+    std::size_t restored = 0;
+    if (read_snapshot(snapshot_path(journal_->directory()), snapshot_sequence_, snapshot))
+    {
+        if (journal_->last_sequence() < snapshot_sequence_)
+            throw std::runtime_error("Journal in " + journal_->directory() + " ends before its snapshot");
+        for (const BookSnapshot &book : snapshot)
+        {
+            book_for(book.symbol).book->restore_orders(book.orders);
+            restored += book.orders.size();
+        }
+    }
+
+    std::uint64_t replayed = 0;
+    Journal::replay(journal_->directory(), [this, &replayed](const JournalEntry &entry) {
+        OrderBook &book = *book_for(entry.symbol).book;
+        try
+        {
+            switch (entry.command)
+            {
+            case JournalCommand::add:
+                book.add_order(entry.id, entry.type, entry.side, entry.price, entry.quantity, entry.stop_price,
+                               entry.display_quantity);
+                break;
+            case JournalCommand::cancel:
+                book.cancel_order(entry.id);
+                break;
+            case JournalCommand::modify:
+                book.modify_order(entry.id, entry.price, entry.quantity);
+                break;
+            case JournalCommand::parameters:
+                break; // folded into its add by Journal::replay
+            }
+        }
+        catch (const std::exception &)
+        {
+            // Only accepted commands are journaled, so this is unreachable short of a changed engine.
+        }
+        ++replayed;
+    }, snapshot_sequence_);
+    logger_.set_level(log_level_);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    logger_.log("Restored " + std::to_string(restored) + " resting order(s) from snapshot at sequence " +
+                std::to_string(snapshot_sequence_) + " and replayed " + std::to_string(replayed) +
+                " journal record(s) from " + journal_->directory() + " in " + std::to_string(elapsed.count()) + " ms");
+}
+
+void ShardPool::Shard::take_snapshot()
+{
+    std::uint64_t sequence = journal_->last_sequence();
+    try
+    {
+        std::vector<BookSnapshot> snapshot;
+        snapshot.reserve(books_.size());
+        for (const auto &[symbol, entry] : books_)
+            snapshot.push_back({symbol, entry.book->get_resting_orders()});
+        write_snapshot(snapshot_path(journal_->directory()), sequence, snapshot);
+        snapshot_sequence_ = sequence;
+        journal_->discard_through(sequence);
+    }
+    catch (const std::exception &e)
+    {
+        // The journal still holds everything; try again after another interval.
+        logger_.log(std::string("Snapshot failed: ") + e.what());
+        snapshot_sequence_ = sequence;
+    }
+}
+
+// Commands applied in a pass whose journal failed may never reach the disk:
+// they are answered with the failure instead of an acknowledgement. Commands
+// refused because the journal had already failed are rejections as they stand.
+void ShardPool::Shard::hold_unjournaled()
+{
+    for (ShardResponse &staged : staged_)
+    {
+        bool mutation = staged.command == ShardCommand::add || staged.command == ShardCommand::cancel ||
+                        staged.command == ShardCommand::modify;
+        if (!mutation || !staged.ok)
+            continue;
+        staged.ok = false;
+        staged.error = "Journal failed before this command was durable; it may have been applied: " + journal_error_;
+        ++stats_.rejects;
+    }
+}
+
+void ShardPool::Shard::fail_journal(const std::string &error)
+{
+    if (!journal_error_.empty())
+        return;
+    journal_error_ = error;
+    logger_.log("Journal failed, refusing further changes to this shard's books: " + error);
+}
+
+void ShardPool::Shard::handle(const ShardRequest &request, ShardResponse &response)
+{
+    response.token = request.token;
+    response.command = request.command;
+    response.symbol = request.symbol;
+    response.id = request.id;
+    response.received_at = request.received_at;
+
+    if (request.command == ShardCommand::stats)
+    {
+        auto stats = std::make_shared<ShardStats>(stats_);
+        stats->books = books_.size();
+        stats->request_queue_depth = requests.size();
+        stats->response_queue_depth = responses.size();
+        response.stats = std::move(stats);
+        return;
+    }
+
+    try
+    {
+        bool mutation = request.command == ShardCommand::add || request.command == ShardCommand::cancel ||
+                        request.command == ShardCommand::modify;
+        if (mutation && !journal_error_.empty())
+            throw std::runtime_error("Journal failed, changes are refused: " + journal_error_);
+        BookEntry &entry = book_for(request.symbol);
+        OrderBook &book = *entry.book;
+        switch (request.command)
+        {
+        case ShardCommand::add:
+        {
+            touch(entry);
+            TradeSequence cursor = book.get_trade_history().next_sequence();
+            std::uint64_t start = stats_stamp();
+            response.status = book.add_order(request.id, request.type, request.side, request.price, request.quantity,
+                                             request.stop_price, request.display_quantity);
+            stats_.stages.record(Stage::match, start, stats_stamp());
+            // Stops the order triggered may have traded among other orders as well.
+            std::uint32_t trades = 0;
+            book.get_trade_history().drain(cursor, [&response, &trades](const Trade &trade) {
+                ++trades;
+                if (trade.get_bid_order_id() != response.id && trade.get_ask_order_id() != response.id)
+                    return;
+                response.filled += trade.get_quantity();
+                ++response.trade_count;
+            });
+            ++stats_.orders;
+            stats_.trades += trades;
+            record(request);
+            break;
+        }
+        case ShardCommand::cancel:
+        {
+            touch(entry);
+            std::uint64_t start = stats_stamp();
+            book.cancel_order(request.id);
+            stats_.stages.record(Stage::match, start, stats_stamp());
+            ++stats_.cancels;
+            record(request);
+            break;
+        }
+        case ShardCommand::modify:
+        {
+            touch(entry);
+            std::uint64_t start = stats_stamp();
+            book.modify_order(request.id, request.price, request.quantity);
+            stats_.stages.record(Stage::match, start, stats_stamp());
+            ++stats_.modifies;
+            record(request);
+            break;
+        }
+        case ShardCommand::summary:
+            response.version = book.get_version();
+            response.unchanged = request.known_version == response.version;
+            if (!response.unchanged)
+            {
+                response.bids = book.get_bids(request.depth);
+                response.asks = book.get_asks(request.depth);
+            }
+            break;
+        case ShardCommand::subscribe:
+            // Earlier changes are queued for existing subscribers (or only
+            // reach the analytics if there are none), so the snapshot
+            // supersedes every update numbered up to its sequence.
+            flush(entry);
+            entry.subscribed = true;
+            response.sequence = entry.update_sequence;
+            response.bids = book.get_bids();
+            response.asks = book.get_asks();
+            break;
+        case ShardCommand::unsubscribe:
+            entry.subscribed = false;
+            break;
+        case ShardCommand::market_data:
+            throw std::runtime_error("market_data is not a request");
+        case ShardCommand::stats:
+            break; // answered above, before any book is looked up
+        case ShardCommand::analytics:
+            flush(entry);
+            response.analytics = std::make_shared<AnalyticsSnapshot>(entry.analytics.snapshot(analytics_now()));
+            break;
+        case ShardCommand::trades:
+            flush(entry);
+            response.trade_history = entry.trade_store.trades(request.from_ns, request.to_ns, request.limit);
+            break;
+        case ShardCommand::bars:
+            flush(entry);
+            response.resolution = request.resolution;
+            response.bars = entry.trade_store.bars(request.resolution, request.from_ns, request.to_ns, request.limit);
+            break;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        response.ok = false;
+        response.error = e.what();
+        ++stats_.rejects;
+    }
+}
+
+void ShardPool::Shard::record(const ShardRequest &request)
+{
+    if (!journal_ || !journal_error_.empty())
+        return;
+    JournalEntry entry;
+    entry.command = request.command == ShardCommand::add      ? JournalCommand::add
+                    : request.command == ShardCommand::cancel ? JournalCommand::cancel
+                                                              : JournalCommand::modify;
+    entry.symbol = request.symbol;
+    entry.id = request.id;
+    entry.type = request.type;
+    entry.side = request.side;
+    entry.price = request.price;
+    entry.quantity = request.quantity;
+    entry.stop_price = request.stop_price;
+    entry.display_quantity = request.display_quantity;
+    try
+    {
+        journal_->append(entry);
+    }
+    catch (const std::exception &e)
+    {
+        // The book has applied the command already; failing the journal fails
+        // the whole pass, so no reply acknowledges it or any other command of the pass.
+        fail_journal(e.what());
+    }
+}
+
+void ShardPool::Shard::publish(ShardResponse &&response)
+{
+    // The front end drains continuously, so a full queue only waits briefly.
+    while (!responses.try_push(std::move(response)))
+        std::this_thread::yield();
+}
+
+bool ShardPool::Shard::collect(BookEntry &entry, ShardResponse &update)
+{
+    OrderBook &book = *entry.book;
+    book.take_level_changes(update.bids, update.asks);
+    // Trades beyond the tape's capacity are lost to the feed; the level deltas still converge.
+    book.get_trade_history().drain(entry.trade_cursor, [&update](const Trade &trade) {
+        update.trades.push_back(trade);
+    });
+    if (update.bids.empty() && update.asks.empty() && update.trades.empty())
+        return false;
+
+    MarketAnalytics &analytics = entry.analytics;
+    for (const OrderLevel &level : update.bids)
+        analytics.on_level(OrderSide::buy, level);
+    for (const OrderLevel &level : update.asks)
+        analytics.on_level(OrderSide::sell, level);
+    if (analytics.needs_refill(OrderSide::buy))
+        analytics.refill(OrderSide::buy, book.get_bids(analytics.depth()));
+    if (analytics.needs_refill(OrderSide::sell))
+        analytics.refill(OrderSide::sell, book.get_asks(analytics.depth()));
+    if (!update.trades.empty())
+    {
+        std::uint64_t now = analytics_now();
+        std::uint64_t time = wall_clock_now();
+        for (const Trade &trade : update.trades)
+        {
+            analytics.on_trade(trade, now);
+            entry.trade_store.append(trade, time);
+        }
+    }
+
+    update.command = ShardCommand::market_data;
+    update.symbol = entry.symbol;
+    return true;
+}
+
+void ShardPool::Shard::flush(BookEntry &entry)
+{
+    ShardResponse update;
+    if (collect(entry, update) && entry.subscribed)
+    {
+        update.sequence = ++entry.update_sequence;
+        updates_.push_back(std::move(update));
+    }
+}
+
+void ShardPool::Shard::track(BookEntry &entry)
+{
+    OrderBook &book = *entry.book;
+    book.set_level_tracking(true);
+    entry.trade_cursor = book.get_trade_history().next_sequence();
+    entry.analytics.refill(OrderSide::buy, book.get_bids(entry.analytics.depth()));
+    entry.analytics.refill(OrderSide::sell, book.get_asks(entry.analytics.depth()));
+}
+
+void ShardPool::Shard::touch(BookEntry &entry)
+{
+    if (entry.touched)
+        return;
+    entry.touched = true;
+    touched_.push_back(&entry);
+}
+
+ShardPool::Shard::BookEntry &ShardPool::Shard::book_for(const Symbol &symbol)
+{
+    auto it = books_.find(symbol);
+    if (it == books_.end())
+    {
+        it = books_.emplace(symbol, BookEntry{symbol, std::make_unique<OrderBook>(&logger_),
+                                              MarketAnalytics(analytics_config_),
+                                              TradeStore(trade_store_config_)}).first;
+        if (tracking_)
+            track(it->second);
+    }
+    return it->second;
+}
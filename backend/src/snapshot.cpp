@@ -0,0 +1,165 @@
+#include "snapshot.hpp"
+#include "byte_order.hpp"
+#include "mapped_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char magic[8] = {'O', 'B', 'S', 'N', 'A', 'P', '0', '2'};
+    constexpr std::size_t header_size = 32;
+    constexpr std::size_t book_header_size = 24;
+    constexpr std::size_t order_size = 40;
+    constexpr std::size_t symbol_size = 16;
+
+    std::uint64_t checksum(const unsigned char *data, std::size_t size)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (std::size_t i = 0; i < size; ++i)
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    [[noreturn]] void throw_system_error(const std::string &what, const std::string &path)
+    {
+        throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+    }
+
+    void write_all(int fd, const unsigned char *data, std::size_t size, const std::string &path)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw_system_error("Cannot write snapshot", path);
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+
+    void sync_directory(const std::string &path)
+    {
+        std::string directory = std::filesystem::path(path).parent_path().string();
+        int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0)
+            return;
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+void write_snapshot(const std::string &path, std::uint64_t sequence, const std::vector<BookSnapshot> &books)
+{
+    std::size_t size = header_size;
+    for (const BookSnapshot &book : books)
+        size += book_header_size + book.orders.size() * order_size;
+
+    std::vector<unsigned char> buffer(size, 0);
+    unsigned char *out = buffer.data();
+    std::memcpy(out, magic, sizeof(magic));
+    store_le<std::uint64_t>(out + 8, sequence);
+    store_le<std::uint32_t>(out + 16, static_cast<std::uint32_t>(books.size()));
+
+    std::size_t offset = header_size;
+    for (const BookSnapshot &book : books)
+    {
+        std::string_view symbol = book.symbol.view();
+        std::memcpy(out + offset, symbol.data(), symbol.size());
+        store_le<std::uint64_t>(out + offset + symbol_size, book.orders.size());
+        offset += book_header_size;
+        for (const RestingOrder &order : book.orders)
+        {
+            store_le<std::uint64_t>(out + offset, order.id);
+            store_le<std::int32_t>(out + offset + 8, order.price);
+            store_le<std::uint32_t>(out + offset + 12, order.initial_quantity);
+            store_le<std::uint32_t>(out + offset + 16, order.remaining_quantity);
+            out[offset + 20] = static_cast<unsigned char>(order.type);
+            out[offset + 21] = static_cast<unsigned char>(order.side);
+            store_le<std::int32_t>(out + offset + 24, order.stop_price);
+            store_le<std::uint32_t>(out + offset + 28, order.display_quantity);
+            store_le<std::uint32_t>(out + offset + 32, order.visible_quantity);
+            offset += order_size;
+        }
+    }
+    store_le<std::uint64_t>(out + 24, checksum(out + header_size, size - header_size));
+
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw_system_error("Cannot create snapshot", temporary);
+    try
+    {
+        write_all(fd, out, size, temporary);
+        if (::fsync(fd) != 0)
+            throw_system_error("Cannot sync snapshot", temporary);
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+
+    if (::rename(temporary.c_str(), path.c_str()) != 0)
+        throw_system_error("Cannot install snapshot", path);
+    sync_directory(path);
+}
+
+bool read_snapshot(const std::string &path, std::uint64_t &sequence, std::vector<BookSnapshot> &books)
+{
+    if (!std::filesystem::exists(path))
+        return false;
+
+    MappedFile file(path);
+    const unsigned char *data = file.data();
+    std::size_t size = file.size();
+    if (size < header_size)
+        throw std::runtime_error("Not a snapshot: " + path);
+    if (std::memcmp(data, magic, sizeof(magic)) != 0)
+        throw std::runtime_error("Not a snapshot: " + path);
+    if (load_le<std::uint64_t>(data + 24) != checksum(data + header_size, size - header_size))
+        throw std::runtime_error("Snapshot checksum mismatch: " + path);
+
+    sequence = load_le<std::uint64_t>(data + 8);
+    std::uint32_t book_count = load_le<std::uint32_t>(data + 16);
+    books.clear();
+    books.reserve(book_count);
+
+    std::size_t offset = header_size;
+    for (std::uint32_t i = 0; i < book_count; ++i)
+    {
+        if (size - offset < book_header_size)
+            throw std::runtime_error("Truncated snapshot: " + path);
+        const char *symbol = reinterpret_cast<const char *>(data + offset);
+        std::uint64_t order_count = load_le<std::uint64_t>(data + offset + symbol_size);
+        offset += book_header_size;
+        if ((size - offset) / order_size < order_count)
+            throw std::runtime_error("Truncated snapshot: " + path);
+
+        BookSnapshot &book = books.emplace_back();
+        book.symbol = Symbol(std::string_view(symbol, strnlen(symbol, Symbol::max_length)));
+        book.orders.resize(order_count);
+        for (RestingOrder &order : book.orders)
+        {
+            order.id = load_le<std::uint64_t>(data + offset);
+            order.price = load_le<std::int32_t>(data + offset + 8);
+            order.initial_quantity = load_le<std::uint32_t>(data + offset + 12);
+            order.remaining_quantity = load_le<std::uint32_t>(data + offset + 16);
+            order.type = static_cast<OrderType>(data[offset + 20]);
+            order.side = static_cast<OrderSide>(data[offset + 21]);
+            order.stop_price = load_le<std::int32_t>(data + offset + 24);
+            order.display_quantity = load_le<std::uint32_t>(data + offset + 28);
+            order.visible_quantity = load_le<std::uint32_t>(data + offset + 32);
+            offset += order_size;
+        }
+    }
+    return true;
+}
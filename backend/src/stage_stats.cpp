@@ -0,0 +1,47 @@
+#include "stage_stats.hpp"
+#include <thread>
+
+const char *stage_name(Stage stage)
+{
+    switch (stage)
+    {
+    case Stage::parse:
+        return "parse";
+    case Stage::queue:
+        return "queue";
+    case Stage::match:
+        return "match";
+    case Stage::commit:
+        return "commit";
+    case Stage::dispatch:
+        return "dispatch";
+    case Stage::serialize:
+        return "serialize";
+    case Stage::write:
+        return "write";
+    case Stage::total:
+        return "total";
+    }
+    return "unknown";
+}
+
+double stats_nanoseconds_per_tick()
+{
+    static const double nanoseconds_per_tick = [] {
+        if constexpr (!stats_compiled)
+            return 0.0;
+        auto start = std::chrono::steady_clock::now();
+        std::uint64_t first = stats_stamp();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::uint64_t last = stats_stamp();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return last > first ? elapsed / static_cast<double>(last - first) : 1.0;
+    }();
+    return nanoseconds_per_tick;
+}
+
+void StageStats::merge(const StageStats &other)
+{
+    for (std::size_t i = 0; i < histograms_.size(); ++i)
+        histograms_[i].merge(other.histograms_[i]);
+}
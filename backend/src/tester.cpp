@@ -5,7 +5,8 @@
 #include <iostream>
 #include <random>
 #include <chrono>
-#include <thread>
+#include <algorithm>
+#include "binary_protocol.hpp"
 
 namespace beast   = boost::beast;           // Boost.Beast
 namespace websocket = beast::websocket;      // WebSocket
@@ -13,7 +14,21 @@ namespace net     = boost::asio;             // Boost.Asio
 namespace json    = boost::json;             // Boost.JSON
 using tcp         = net::ip::tcp;
 
-int main() {
+int main(int argc, char *argv[]) {
+    // Options: --binary speaks the compact binary protocol instead of JSON;
+    // --batch N packs N orders per frame; --window W keeps up to W frames in flight.
+    bool binary = false;
+    int batchSize = 50;
+    int window = 8;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--binary")
+            binary = true;
+        else if (arg == "--batch" && i + 1 < argc)
+            batchSize = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--window" && i + 1 < argc)
+            window = std::max(1, std::stoi(argv[++i]));
+    }
     try {
         // Create an io_context
         net::io_context ioc;
@@ -25,8 +40,28 @@ int main() {
         // Create the WebSocket stream and connect
         websocket::stream<tcp::socket> ws(ioc);
         net::connect(ws.next_layer(), results.begin(), results.end());
-        ws.handshake("127.0.0.1", "/");
-        std::cout << "Connected to WebSocket server." << std::endl;
+        if (binary) {
+            ws.set_option(websocket::stream_base::decorator([](websocket::request_type &request) {
+                request.set(beast::http::field::sec_websocket_protocol, binary_subprotocol);
+            }));
+            websocket::response_type handshake_response;
+            ws.handshake(handshake_response, "127.0.0.1", "/");
+            if (handshake_response[beast::http::field::sec_websocket_protocol] != binary_subprotocol)
+                throw std::runtime_error("Server did not accept the binary protocol");
+            ws.binary(true);
+        } else {
+            ws.handshake("127.0.0.1", "/");
+        }
+        std::cout << "Connected to WebSocket server (" << (binary ? "binary" : "JSON") << ")." << std::endl;
+
+        // Renders a response frame in either format.
+        auto describe = [binary](const beast::flat_buffer &buffer) {
+            if (!binary)
+                return beast::buffers_to_string(buffer.data());
+            auto frame = buffer.data();
+            return describe_binary_response(
+                decode_binary_response(static_cast<const unsigned char *>(frame.data()), frame.size()));
+        };
 
         // Setup random generator for simulated orders
         std::random_device rd;
@@ -38,45 +73,77 @@ int main() {
 
         const int numOrders = 1000; // Number of simulated orders
 
-        // Loop to send simulated orders
-        for (int i = 0; i < numOrders; i++) {
+        // Appends one randomized order to the frame being built.
+        json::array jsonBatch;
+        auto appendOrder = [&](std::string &frame, int id) {
             int price    = priceDist(gen);
             int quantity = quantityDist(gen);
             std::string orderType = (typeDist(gen) == 0) ? "GTC" : "IOC";
             std::string side = (sideDist(gen) == 0) ? "buy" : "sell";
 
+            if (binary) {
+                encode_new_order(frame, default_symbol, static_cast<OrderID>(id),
+                                 orderType == "GTC" ? OrderType::good_till_cancel : OrderType::immediate_or_cancel,
+                                 side == "buy" ? OrderSide::buy : OrderSide::sell, price, quantity);
+                return;
+            }
             // Construct the order JSON
             json::object orderMsg;
-            orderMsg["id"] = std::to_string(i + 1);
+            orderMsg["id"] = std::to_string(id);
             orderMsg["type"] = orderType;
             orderMsg["side"] = side;
             orderMsg["price"] = price;
             orderMsg["quantity"] = quantity;
-            std::string message = json::serialize(orderMsg);
-
-            // Send the order over the WebSocket
-            ws.write(net::buffer(message));
+            jsonBatch.push_back(orderMsg);
+        };
 
-            // Read the server response
+        // Frames are pipelined: up to `window` are written before the oldest reply is read.
+        int inFlight = 0;
+        int frames = 0;
+        auto readReply = [&]() {
             beast::flat_buffer buffer;
             ws.read(buffer);
-            std::string response = beast::buffers_to_string(buffer.data());
-            std::cout << "Order " << (i + 1) << " response: " << response << std::endl;
+            --inFlight;
+            std::cout << "Frame " << ++frames << " response: " << describe(buffer) << std::endl;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        for (int first = 1; first <= numOrders; first += batchSize) {
+            int count = std::min(batchSize, numOrders - first + 1);
+            std::string message;
+            jsonBatch.clear();
+            if (binary)
+                encode_batch_header(message, BinaryMessage::batch, static_cast<std::uint32_t>(count));
+            for (int id = first; id < first + count; id++)
+                appendOrder(message, id);
+            if (!binary)
+                message = json::serialize(jsonBatch);
 
-            // Pause briefly between orders
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (inFlight == window)
+                readReply();
+            ws.write(net::buffer(message));
+            ++inFlight;
         }
+        while (inFlight > 0)
+            readReply();
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Sent " << numOrders << " orders in " << frames << " frames, "
+                  << static_cast<long long>(numOrders / elapsed) << " orders/s" << std::endl;
 
         // Request a summary of the order book
-        json::object summaryCmd;
-        summaryCmd["command"] = "summary";
-        std::string summaryMsg = json::serialize(summaryCmd);
+        std::string summaryMsg;
+        if (binary) {
+            encode_summary(summaryMsg, default_symbol, 0);
+        } else {
+            json::object summaryCmd;
+            summaryCmd["command"] = "summary";
+            summaryMsg = json::serialize(summaryCmd);
+        }
         ws.write(net::buffer(summaryMsg));
 
         beast::flat_buffer summaryBuffer;
         ws.read(summaryBuffer);
-        std::string summaryResponse = beast::buffers_to_string(summaryBuffer.data());
-        std::cout << "Order Book Summary: " << summaryResponse << std::endl;
+        std::cout << "Order Book Summary: " << describe(summaryBuffer) << std::endl;
 
         // Close the WebSocket connection normally.
         ws.close(websocket::close_code::normal);
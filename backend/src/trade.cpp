@@ -1,7 +1,12 @@
 #include "trade.hpp"
 
-Trade::Trade(const TradeInfo &bid_trade, const TradeInfo &ask_trade)
-    : bid_trade_(bid_trade), ask_trade_(ask_trade) {}
+Trade::Trade(OrderID bid_order_id, OrderID ask_order_id, Price price, Quantity quantity)
+    : bid_order_id_(bid_order_id), ask_order_id_(ask_order_id), price_(price), quantity_(quantity) {}
 
-const TradeInfo &Trade::get_bid_trade() const { return bid_trade_; }
-const TradeInfo &Trade::get_ask_trade() const { return ask_trade_; }
+OrderID Trade::get_bid_order_id() const { return bid_order_id_; }
+OrderID Trade::get_ask_order_id() const { return ask_order_id_; }
+Price Trade::get_price() const { return price_; }
+Quantity Trade::get_quantity() const { return quantity_; }
+
+TradeInfo Trade::get_bid_trade() const { return {bid_order_id_, price_, quantity_}; }
+TradeInfo Trade::get_ask_trade() const { return {ask_order_id_, price_, quantity_}; }
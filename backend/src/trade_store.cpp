@@ -0,0 +1,163 @@
+#include "trade_store.hpp"
+#include <algorithm>
+
+std::uint64_t bar_width_ns(BarResolution resolution)
+{
+    constexpr std::uint64_t second = 1'000'000'000;
+    switch (resolution)
+    {
+    case BarResolution::one_second:
+        return second;
+    case BarResolution::one_minute:
+        return 60 * second;
+    case BarResolution::five_minutes:
+        return 300 * second;
+    }
+    return second;
+}
+
+const char *bar_resolution_name(BarResolution resolution)
+{
+    switch (resolution)
+    {
+    case BarResolution::one_second:
+        return "1s";
+    case BarResolution::one_minute:
+        return "1m";
+    case BarResolution::five_minutes:
+        return "5m";
+    }
+    return "1s";
+}
+
+TradeStore::TradeStore(const TradeStoreConfig &config) : config_(config)
+{
+    config_.block_trades = std::max<std::size_t>(config_.block_trades, 1);
+    config_.max_trades = std::max<std::size_t>(config_.max_trades, 1);
+    config_.partition_ns = std::max<std::uint64_t>(config_.partition_ns, 1);
+    config_.max_bars = std::max<std::size_t>(config_.max_bars, 1);
+}
+
+void TradeStore::append(const Trade &trade, std::uint64_t time_ns)
+{
+    time_ns = std::max(time_ns, last_time_);
+    last_time_ = time_ns;
+
+    Block &block = block_for(time_ns);
+    block.times.push_back(time_ns);
+    block.prices.push_back(trade.get_price());
+    block.quantities.push_back(trade.get_quantity());
+    block.bid_order_ids.push_back(trade.get_bid_order_id());
+    block.ask_order_ids.push_back(trade.get_ask_order_id());
+    ++size_;
+    evict();
+
+    Price price = trade.get_price();
+    for (std::size_t i = 0; i < bar_resolution_count; ++i)
+    {
+        std::uint64_t width = bar_width_ns(static_cast<BarResolution>(i));
+        std::uint64_t start = time_ns - time_ns % width;
+        std::deque<Bar> &series = bars_[i];
+        if (series.empty() || series.back().start_ns != start)
+        {
+            if (series.size() == config_.max_bars)
+                series.pop_front();
+            series.push_back({start, price, price, price, price, 0, 0});
+        }
+        Bar &bar = series.back();
+        bar.high = std::max(bar.high, price);
+        bar.low = std::min(bar.low, price);
+        bar.close = price;
+        bar.volume += trade.get_quantity();
+        ++bar.trades;
+    }
+}
+
+TradeStore::Block &TradeStore::block_for(std::uint64_t time_ns)
+{
+    std::uint64_t partition = time_ns / config_.partition_ns;
+    if (!blocks_.empty() && blocks_.back().partition == partition && blocks_.back().size() < config_.block_trades)
+        return blocks_.back();
+
+    if (!blocks_.empty() && blocks_.back().size() < config_.block_trades)
+    {
+        // Closed by its partition: with sparse trading most blocks end here.
+        Block &closed = blocks_.back();
+        closed.times.shrink_to_fit();
+        closed.prices.shrink_to_fit();
+        closed.quantities.shrink_to_fit();
+        closed.bid_order_ids.shrink_to_fit();
+        closed.ask_order_ids.shrink_to_fit();
+    }
+
+    // Start in the spare's columns if there is one; reserve tops them up otherwise.
+    Block block = std::move(spare_);
+    spare_ = Block{};
+    block.partition = partition;
+    block.times.reserve(config_.block_trades);
+    block.prices.reserve(config_.block_trades);
+    block.quantities.reserve(config_.block_trades);
+    block.bid_order_ids.reserve(config_.block_trades);
+    block.ask_order_ids.reserve(config_.block_trades);
+    blocks_.push_back(std::move(block));
+    return blocks_.back();
+}
+
+void TradeStore::evict()
+{
+    while (blocks_.size() > 1 && size_ - blocks_.front().size() >= config_.max_trades)
+    {
+        size_ -= blocks_.front().size();
+        spare_ = std::move(blocks_.front());
+        blocks_.pop_front();
+        spare_.times.clear();
+        spare_.prices.clear();
+        spare_.quantities.clear();
+        spare_.bid_order_ids.clear();
+        spare_.ask_order_ids.clear();
+    }
+}
+
+std::vector<TimedTrade> TradeStore::trades(std::uint64_t from_ns, std::uint64_t to_ns, std::size_t limit) const
+{
+    std::vector<TimedTrade> result;
+    if (limit == 0 || from_ns > to_ns)
+        return result;
+
+    // Blocks are never empty and their times ascend across the deque.
+    auto first = std::partition_point(blocks_.begin(), blocks_.end(),
+                                      [from_ns](const Block &block) { return block.times.back() < from_ns; });
+    auto last = std::partition_point(first, blocks_.end(),
+                                     [to_ns](const Block &block) { return block.times.front() <= to_ns; });
+    for (auto it = last; it != first && result.size() < limit;)
+    {
+        const Block &block = *--it;
+        std::size_t begin = static_cast<std::size_t>(
+            std::lower_bound(block.times.begin(), block.times.end(), from_ns) - block.times.begin());
+        std::size_t end = static_cast<std::size_t>(
+            std::upper_bound(block.times.begin(), block.times.end(), to_ns) - block.times.begin());
+        for (std::size_t i = end; i > begin && result.size() < limit;)
+        {
+            --i;
+            result.push_back({block.times[i], Trade(block.bid_order_ids[i], block.ask_order_ids[i],
+                                                    block.prices[i], block.quantities[i])});
+        }
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+std::vector<Bar> TradeStore::bars(BarResolution resolution, std::uint64_t from_ns, std::uint64_t to_ns,
+                                  std::size_t limit) const
+{
+    const std::deque<Bar> &series = bars_[static_cast<std::size_t>(resolution)];
+    if (limit == 0 || from_ns > to_ns)
+        return {};
+    auto begin = std::partition_point(series.begin(), series.end(),
+                                      [from_ns](const Bar &bar) { return bar.start_ns < from_ns; });
+    auto end = std::partition_point(begin, series.end(),
+                                    [to_ns](const Bar &bar) { return bar.start_ns <= to_ns; });
+    if (static_cast<std::size_t>(end - begin) > limit)
+        begin = end - static_cast<std::ptrdiff_t>(limit);
+    return std::vector<Bar>(begin, end);
+}
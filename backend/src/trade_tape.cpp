@@ -0,0 +1,22 @@
+#include "trade_tape.hpp"
+#include <bit>
+#include <stdexcept>
+
+TradeTape::TradeTape(std::size_t capacity)
+{
+    if (capacity == 0)
+        throw std::invalid_argument("TradeTape capacity must be positive");
+    trades_.resize(std::bit_ceil(capacity));
+    mask_ = trades_.size() - 1;
+}
+
+void TradeTape::publish(const Trade &trade)
+{
+    trades_[next_sequence_ & mask_] = trade;
+    ++next_sequence_;
+}
+
+TradeSequence TradeTape::first_sequence() const
+{
+    return next_sequence_ > trades_.size() ? next_sequence_ - trades_.size() : 0;
+}
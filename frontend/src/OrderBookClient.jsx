@@ -1,5 +1,5 @@
 // OrderBookClient.jsx
-import React, { useState, useEffect } from 'react';
+import React, { useState, useEffect, useRef } from 'react';
 import { Line } from 'react-chartjs-2';
 import 'chart.js/auto';
 
@@ -145,6 +145,17 @@ const calculateMetrics = (summary, midPrices) => {
     return { bestBid, bestAsk, spread, midPrice, totalBidVolume, totalAskVolume, volatility };
 };
 
+// Applies market-data level deltas to one side of the book. A delta carries
+// the level's new aggregate quantity; zero removes the level.
+const applyLevelDeltas = (levels, deltas, descending) => {
+    const byPrice = new Map(levels.map(level => [level.price, level]));
+    deltas.forEach(delta => {
+        if (delta.quantity === 0) byPrice.delete(delta.price);
+        else byPrice.set(delta.price, { price: delta.price, quantity: delta.quantity });
+    });
+    return [...byPrice.values()].sort((a, b) => (descending ? b.price - a.price : a.price - b.price));
+};
+
 const OrderBookClient = () => {
     const [ws, setWs] = useState(null);
     const [connected, setConnected] = useState(false);
@@ -156,25 +167,46 @@ const OrderBookClient = () => {
     const [price, setPrice] = useState('');
     const [quantity, setQuantity] = useState('');
     const [midPriceSeries, setMidPriceSeries] = useState([]);
+    // Book and sequence of the last market-data message applied to `summary`.
+    const bookRef = useRef({ bids: [], asks: [] });
+    const sequenceRef = useRef(null);
 
     // Establish WebSocket connection on mount.
     useEffect(() => {
         const socket = new WebSocket('ws://localhost:8080');
+        const recordMidPrice = book => {
+            if (book.bids.length > 0 && book.asks.length > 0) {
+                const midPrice = (book.bids[0].price + book.asks[0].price) / 2;
+                const now = new Date().toLocaleTimeString();
+                setMidPriceSeries(prev => [...prev, { time: now, midPrice }]);
+            }
+        };
         socket.onopen = () => {
             setConnected(true);
             console.log('Connected to server');
+            // One snapshot, then pushed level deltas and trades.
+            socket.send(JSON.stringify({ command: 'subscribe' }));
         };
         socket.onmessage = event => {
             try {
                 const data = JSON.parse(event.data);
-                // If message contains bids and asks, update summary and record mid price.
-                if (data.bids && data.asks) {
-                    setSummary(data);
-                    if (data.bids.length > 0 && data.asks.length > 0) {
-                        const midPrice = (data.bids[0].price + data.asks[0].price) / 2;
-                        const now = new Date().toLocaleTimeString();
-                        setMidPriceSeries(prev => [...prev, { time: now, midPrice }]);
-                    }
+                if (data.type === 'snapshot') {
+                    sequenceRef.current = data.sequence;
+                    const book = { bids: data.bids, asks: data.asks };
+                    bookRef.current = book;
+                    setSummary(book);
+                    recordMidPrice(book);
+                } else if (data.type === 'update') {
+                    // Updates at or below the snapshot's sequence are already reflected in it.
+                    if (sequenceRef.current === null || data.sequence <= sequenceRef.current) return;
+                    sequenceRef.current = data.sequence;
+                    const book = {
+                        bids: applyLevelDeltas(bookRef.current.bids, data.bids, true),
+                        asks: applyLevelDeltas(bookRef.current.asks, data.asks, false),
+                    };
+                    bookRef.current = book;
+                    setSummary(book);
+                    recordMidPrice(book);
                 } else {
                     setMessages(prev => [...prev, data]);
                 }
@@ -193,16 +225,6 @@ const OrderBookClient = () => {
         };
     }, []);
 
-    // Automatically request summary every second.
-    useEffect(() => {
-        if (ws && connected) {
-            const interval = setInterval(() => {
-                ws.send(JSON.stringify({ command: 'summary' }));
-            }, 1000);
-            return () => clearInterval(interval);
-        }
-    }, [ws, connected]);
-
     const sendOrder = () => {
         if (ws && connected) {
             const order = {